@@ -0,0 +1,101 @@
+#include "arena.h"
+
+#include <stdlib.h> /* allocation functions */
+#include <stdio.h>
+
+/*
+type with the strictest alignment needed by allocations
+*/
+typedef union arena_align{
+	long l;
+	double d;
+	void* p;
+} ArenaAlign;
+
+/*
+rounds size up to multiple of alignment
+*/
+#define ALIGN_SIZE(size) (((size) + sizeof(ArenaAlign) - 1) / sizeof(ArenaAlign) * sizeof(ArenaAlign))
+
+/*
+allocates slab with "size" bytes of data
+*/
+ArenaSlab* create_slab(size_t size){
+	ArenaSlab* slab = malloc(ALIGN_SIZE(sizeof(ArenaSlab)) + size);
+	if(slab == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
+		return NULL;
+	}
+	slab->next = NULL;
+	slab->size = size;
+	slab->used = 0;
+	return slab;
+}
+
+Arena* create_arena(size_t slab_size){
+	Arena* arena = malloc(sizeof(Arena));
+	if(arena == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
+		return NULL;
+	}
+
+	arena->slab_size = ALIGN_SIZE(slab_size);
+	arena->first = arena->current = create_slab(arena->slab_size);
+	if(arena->first == NULL){
+		free(arena);
+		return NULL;
+	}
+
+	return arena;
+}
+
+void free_arena(Arena* arena){
+	ArenaSlab* next;
+	while(arena->first){
+		next = arena->first->next;
+		free(arena->first);
+		arena->first = next;
+	}
+	free(arena);
+}
+
+void* arena_alloc(Arena* arena, size_t size){
+	ArenaSlab* slab = arena->current;
+	void* ptr;
+
+	size = ALIGN_SIZE(size);
+
+	if(slab->size - slab->used < size){
+		/* current slab is full, move to next one */
+		if(slab->next && slab->next->size >= size){
+			slab = slab->next; /* reuse released slab */
+		}
+		else{
+			/* new slab between current and released ones */
+			ArenaSlab* new_slab = create_slab(size > arena->slab_size ? size : arena->slab_size);
+			if(new_slab == NULL) return NULL;
+			new_slab->next = slab->next;
+			slab->next = new_slab;
+			slab = new_slab;
+		}
+		slab->used = 0;
+		arena->current = slab;
+	}
+
+	ptr = (char*)slab + ALIGN_SIZE(sizeof(ArenaSlab)) + slab->used;
+	slab->used += size;
+	return ptr;
+}
+
+ArenaMark arena_mark(Arena* arena){
+	ArenaMark mark;
+	mark.slab = arena->current;
+	mark.used = arena->current->used;
+	return mark;
+}
+
+void arena_release(Arena* arena, ArenaMark mark){
+	/* later slabs stay linked after mark's slab and are reused by next allocations */
+	arena->current = mark.slab;
+	arena->current->used = mark.used;
+}
@@ -0,0 +1,64 @@
+#ifndef _ARENA_H
+#define _ARENA_H
+/*
+arena module
+bump allocator handing out memory from large slabs,
+memory is released by moving back to an earlier position (all later allocations are released together)
+*/
+
+#include <stddef.h> /* size_t */
+
+/*
+slab of memory, data follows the structure
+*/
+typedef struct arena_slab{
+	struct arena_slab* next; /* next slab, slabs after current one are kept for reuse */
+	size_t size; /* bytes of data in slab */
+	size_t used; /* bytes already handed out */
+} ArenaSlab;
+
+/*
+structure of an arena
+*/
+typedef struct arena_struct{
+	ArenaSlab* first;
+	ArenaSlab* current; /* slab allocations are made from */
+	size_t slab_size; /* size of new slabs */
+} Arena;
+
+/*
+position in arena, used to release all allocations made after it
+*/
+typedef struct arena_mark{
+	ArenaSlab* slab;
+	size_t used;
+} ArenaMark;
+
+/*
+creates arena with given slab size
+on error returns NULL
+*/
+Arena* create_arena(size_t slab_size);
+
+/*
+frees arena with all its memory
+*/
+void free_arena(Arena* arena);
+
+/*
+allocates "size" bytes from arena
+on error returns NULL
+*/
+void* arena_alloc(Arena* arena, size_t size);
+
+/*
+returns current position of arena
+*/
+ArenaMark arena_mark(Arena* arena);
+
+/*
+releases all allocations made after given position
+*/
+void arena_release(Arena* arena, ArenaMark mark);
+
+#endif
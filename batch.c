@@ -0,0 +1,478 @@
+#include "batch.h"
+#include "pool.h"
+#include "store.h"
+
+#include <stdlib.h> /* allocation functions */
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h> /* character handling */
+#include <time.h> /* clock */
+
+/*
+data shared by all tasks of batch generation
+*/
+typedef struct generate_job{
+	Options* options;
+	GenOptions* gen;
+	
+	Game** games; /* empty game of each worker, games are not thread safe (solver context, board pool) */
+	Random* rngs; /* random generator of each worker */
+	
+	pthread_mutex_t lock; /* protects fields below */
+	Board** results; /* puzzles finished but not written yet, by index (NULL if generator failed) */
+	bool* finished; /* whether each puzzle is finished */
+	int next; /* next puzzle to write */
+	int failed; /* number of puzzles generator failed on */
+	bool error;
+	FILE* output;
+	bool packed; /* whether output is a packed container (see packed module) */
+	PackedWriter writer; /* writer of packed output */
+} GenerateJob;
+
+/*
+task generating a single puzzle
+*/
+typedef struct generate_task{
+	GenerateJob* job;
+	int index; /* index of puzzle */
+} GenerateTask;
+
+/*
+generates puzzle of task, then writes all finished puzzles which are next in order
+*/
+void generate_task(void* arg, int worker){
+	GenerateTask* task = arg;
+	GenerateJob* job = task->job;
+	Game* game = job->games[worker];
+	Random* rng = &job->rngs[worker];
+	Board* puzzle;
+	Board* result = NULL; /* puzzle, not from board pool of worker */
+	bool error = false, skip;
+	
+	pthread_mutex_lock(&job->lock);
+	skip = job->error;
+	pthread_mutex_unlock(&job->lock);
+	
+	if(! skip){
+		/* each puzzle has its own stream, so it does not depend on worker running it */
+		seed_random(rng, job->options->seed, task->index);
+		
+		puzzle = generate(game, job->options->add, job->options->remain, job->gen, rng);
+		if(puzzle == NULL) error = true;
+		else if(puzzle != game->board){
+			/* results are written and freed by other workers */
+			result = copy_board_to(puzzle, NULL);
+			if(result == NULL) error = true;
+			free_board(puzzle);
+		}
+	}
+	
+	pthread_mutex_lock(&job->lock);
+	job->results[task->index] = result;
+	job->finished[task->index] = true;
+	if(error) job->error = true;
+	else if(result == NULL && ! skip) job->failed++;
+	
+	while(job->next < job->options->generate && job->finished[job->next]){
+		if(job->results[job->next] != NULL){
+			/* all values are fixed */
+			if(job->packed){
+				if(! job->error && ! write_packed(&job->writer, job->results[job->next], NULL)) job->error = true;
+			}
+			else if(! job->error && ! write_board(job->output, job->results[job->next], NULL)){
+				fprintf(stderr, "Error: fwrite has failed\n");
+				job->error = true;
+			}
+			free_board(job->results[job->next]);
+			job->results[job->next] = NULL;
+		}
+		job->next++;
+	}
+	pthread_mutex_unlock(&job->lock);
+}
+
+/*
+frees games of first "num" workers, and job arrays
+*/
+void free_generate_job(GenerateJob* job, int num){
+	int i;
+	for(i = 0; i < num; i++) free_game(job->games[i]);
+	free(job->games);
+	free(job->rngs);
+	free(job->results);
+	free(job->finished);
+}
+
+bool batch_generate(Options* options, GenOptions* gen){
+	GenerateJob job;
+	GenerateTask* tasks;
+	ThreadPool* pool;
+	int N = options->cell_w * options->cell_h;
+	int i, count = options->generate, threads = options->threads;
+	
+	if(N > MAX_BOARD_SIZE){
+		fprintf(stderr,"Error: board size must be between 1 and %d\n", MAX_BOARD_SIZE);
+		return false;
+	}
+	if(options->add > N*N || options->remain > N*N){
+		fprintf(stderr, "Error: fill values should be at most %d\n", N*N);
+		return false;
+	}
+	
+	job.options = options;
+	job.gen = gen;
+	job.next = job.failed = 0;
+	job.error = false;
+	
+	job.games = calloc(threads, sizeof(Game*));
+	job.rngs = calloc(threads, sizeof(Random));
+	job.results = calloc(count, sizeof(Board*));
+	job.finished = calloc(count, sizeof(bool));
+	tasks = calloc(count, sizeof(GenerateTask));
+	if(job.games == NULL || job.rngs == NULL || job.results == NULL || job.finished == NULL || tasks == NULL){
+		fprintf(stderr,"Error: calloc has failed\n");
+		free_generate_job(&job, 0);
+		free(tasks);
+		return false;
+	}
+	
+	for(i = 0; i < threads; i++){
+		job.games[i] = create_game(options->cell_w, options->cell_h);
+		if(job.games[i] == NULL){
+			free_generate_job(&job, i);
+			free(tasks);
+			return false;
+		}
+	}
+	
+	job.packed = options->output != NULL && has_packed_extension(options->output);
+	if(options->output == NULL) job.output = stdout;
+	else{
+		job.output = fopen(options->output, job.packed ? "wb" : "w");
+		if(job.output == NULL){
+			fprintf(stderr, "Error: File cannot be opened\n");
+			free_generate_job(&job, threads);
+			free(tasks);
+			return false;
+		}
+	}
+	if(job.packed && ! open_packed_writer(job.output, &job.writer)){
+		fclose(job.output);
+		free_generate_job(&job, threads);
+		free(tasks);
+		return false;
+	}
+	
+	pool = create_pool(threads);
+	if(pool == NULL){
+		if(job.packed) close_packed_writer(&job.writer);
+		if(options->output != NULL) fclose(job.output);
+		free_generate_job(&job, threads);
+		free(tasks);
+		return false;
+	}
+	pthread_mutex_init(&job.lock, NULL);
+	
+	for(i = 0; i < count; i++){
+		tasks[i].job = &job;
+		tasks[i].index = i;
+		if(! pool_submit(pool, -1, generate_task, &tasks[i])){
+			/* mark remaining puzzles as skipped */
+			pthread_mutex_lock(&job.lock);
+			job.error = true;
+			for(; i < count; i++) job.finished[i] = true;
+			pthread_mutex_unlock(&job.lock);
+		}
+	}
+	
+	free_pool(pool); /* waits for all tasks */
+	pthread_mutex_destroy(&job.lock);
+	
+	if(job.packed && ! close_packed_writer(&job.writer)) job.error = true; /* index is written after all puzzles */
+	
+	if(options->output != NULL && fclose(job.output) != 0){
+		fprintf(stderr, "Error: fclose has failed\n");
+		job.error = true;
+	}
+	
+	if(job.failed > 0) fprintf(stderr, "Error: puzzle generator failed on %d puzzles\n", job.failed);
+	
+	free_generate_job(&job, threads);
+	free(tasks);
+	return ! job.error;
+}
+
+/*
+boards and solver context for puzzles of the same dimensions
+*/
+typedef struct solve_context{
+	int cell_w, cell_h; /* dimensions of current puzzles, 0 before first puzzle */
+	BoardPool* pool;
+	SolverContext* solver; /* NULL when counting */
+} SolveContext;
+
+/*
+frees pool and solver of context
+*/
+void clear_solve_context(SolveContext* context){
+	if(context->solver) free_solver(context->solver);
+	if(context->pool) free_board_pool(context->pool);
+	context->solver = NULL;
+	context->pool = NULL;
+	context->cell_w = context->cell_h = 0;
+}
+
+/*
+returns empty board with given dimensions from pool of context, replacing pool and solver if dimensions changed
+on error returns NULL
+*/
+Board* context_board(Options* options, SolveContext* context, int cell_w, int cell_h){
+	/* puzzles usually have same dimensions, so pool and solver are kept */
+	if(cell_w != context->cell_w || cell_h != context->cell_h){
+		clear_solve_context(context);
+		context->pool = create_board_pool(cell_w, cell_h);
+		if(context->pool == NULL) return NULL;
+		if(! options->count){
+			context->solver = create_solver(cell_w, cell_h);
+			if(context->solver == NULL){
+				clear_solve_context(context);
+				return NULL;
+			}
+		}
+		context->cell_w = cell_w;
+		context->cell_h = cell_h;
+	}
+	
+	return create_pool_board(context->pool);
+}
+
+/*
+writes solution or solution count of puzzle, then frees it
+returns whether successful
+*/
+bool solve_board(Options* options, SolveContext* context, Board* board){
+	Board* sol;
+	
+	if(options->count){
+		WideCount count;
+		char count_str[COUNT_STRING_LENGTH];
+		bool interrupted = false;
+		
+		/* progress goes to stderr, so output has only a line per puzzle */
+		if(check_board(board)) clear_count(&count); /* erroneous board has no solutions */
+		else if(! count_solutions(board, options->threads, options->count_limit, stderr, &count, &interrupted)){
+			free_board(board);
+			return false;
+		}
+		
+		count_to_string(&count, count_str);
+		if(interrupted || (options->count_limit > 0 && compare_count(&count, options->count_limit) == 0)){
+			printf("at least %s\n", count_str); /* partial count is a lower bound */
+		}
+		else printf("%s\n", count_str);
+		
+		free_board(board);
+		return ! interrupted; /* interrupt stops batch */
+	}
+	
+	sol = solve_with(context->solver, board);
+	if(sol == NULL){
+		free_board(board);
+		return false;
+	}
+	if(sol == board) printf("unsolvable\n");
+	else{
+		bool written = write_board(stdout, sol, NULL);
+		free_board(sol);
+		if(! written){
+			fprintf(stderr, "Error: fwrite has failed\n");
+			free_board(board);
+			return false;
+		}
+	}
+	free_board(board);
+	return true;
+}
+
+/*
+scans puzzle with given dimensions, and writes its solution or solution count
+returns whether successful
+*/
+bool solve_puzzle(Options* options, SolveContext* context, BoardScanner* scanner, int cell_w, int cell_h){
+	Board* board = context_board(options, context, cell_w, cell_h);
+	
+	if(board == NULL) return false;
+	if(! scan_values(scanner, board, NULL)){
+		free_board(board);
+		return false;
+	}
+	return solve_board(options, context, board);
+}
+
+/*
+solves all puzzles of store
+returns whether successful, and adds number of puzzles solved to "puzzles"
+*/
+bool solve_store(Options* options, SolveContext* context, PuzzleStore* store, int* puzzles){
+	long i;
+	
+	for(i = 0; i < store_count(store); i++){
+		PuzzleView view;
+		Board* board;
+		
+		/* puzzle is read from store in place */
+		if(! store_view(store, i, &view)) return false;
+		board = context_board(options, context, view.cell_w, view.cell_h);
+		if(board == NULL) return false;
+		if(! view_to_board(&view, board, NULL)){
+			free_board(board);
+			return false;
+		}
+		if(! solve_board(options, context, board)) return false;
+		(*puzzles)++;
+	}
+	return true;
+}
+
+/*
+solves puzzle of saved game file, or all puzzles of packed container
+returns whether successful, and adds number of puzzles solved to "puzzles"
+*/
+bool solve_file(Options* options, SolveContext* context, char* filename, int* puzzles){
+	BoardScanner scanner;
+	PuzzleStore store;
+	FILE* file;
+	int cell_w, cell_h;
+	bool success;
+	
+	/* containers are mapped, other files are read whole */
+	switch(open_store(filename, &store)){
+	case 1:
+		success = solve_store(options, context, &store, puzzles);
+		close_store(&store);
+		if(! success) fprintf(stderr, "Error: failed on %s\n", filename);
+		return success;
+	case 0:
+		break;
+	default:
+		fprintf(stderr, "Error: failed on %s\n", filename);
+		return false;
+	}
+	
+	file = fopen(filename, "rb");
+	if(file == NULL){
+		fprintf(stderr, "Error: File %s doesn't exist or cannot be opened\n", filename);
+		return false;
+	}
+	success = open_scanner(file, &scanner);
+	fclose(file);
+	if(! success) return false;
+	
+	switch(scan_dimensions(&scanner, &cell_w, &cell_h)){
+	case 1:
+		success = solve_puzzle(options, context, &scanner, cell_w, cell_h);
+		if(success) (*puzzles)++;
+		break;
+	case 0:
+		fprintf(stderr, "Error: %s is empty\n", filename);
+		/* fall through */
+	default:
+		success = false;
+		break;
+	}
+	
+	if(! success) fprintf(stderr, "Error: failed on %s\n", filename);
+	close_scanner(&scanner);
+	return success;
+}
+
+/*
+solves all puzzles of text input, which is either puzzles in saved game format one after another,
+a packed container, or names of saved game files, one per line
+returns whether successful, and adds number of puzzles solved to "puzzles"
+*/
+bool solve_input(Options* options, SolveContext* context, BoardScanner* input, int* puzzles){
+	PuzzleStore store;
+	int result, cell_w, cell_h;
+	bool success = true;
+	
+	/* input starting with a number has puzzles, otherwise it has file names */
+	skip_blanks(input);
+	
+	if(is_packed((unsigned char*)input->text, input->length)){
+		/* container from a stream, already in memory */
+		return open_memory_store((unsigned char*)input->text, input->length, &store) &&
+				solve_store(options, context, &store, puzzles);
+	}
+	
+	if(isdigit((unsigned char)*input->pos)){
+		while(success && (result = scan_dimensions(input, &cell_w, &cell_h)) != 0){
+			success = result == 1 && solve_puzzle(options, context, input, cell_w, cell_h);
+			if(success) (*puzzles)++;
+		}
+	}
+	else{
+		char* line = input->pos;
+		while(success && *line != '\0'){
+			char* next = strchr(line, '\n');
+			char* end;
+			
+			if(next == NULL) next = line + strlen(line); /* last line has no newline */
+			else *next++ = '\0';
+			
+			for(end = line + strlen(line); end > line && isspace((unsigned char)end[-1]); end--); /* remove trailing blanks */
+			*end = '\0';
+			
+			if(line[0] != '\0'){ /* skip blank lines */
+				success = solve_file(options, context, line, puzzles);
+			}
+			line = next;
+		}
+	}
+	return success;
+}
+
+bool batch_solve(Options* options){
+	SolveContext context;
+	BoardScanner input;
+	PuzzleStore store;
+	FILE* file;
+	int puzzles = 0, result = 0;
+	bool success;
+	clock_t start = clock();
+	
+	/* a container file is mapped, not read */
+	if(strcmp(options->solve, "-") != 0 && (result = open_store(options->solve, &store)) < 0) return false;
+	
+	if(result == 0){
+		if(strcmp(options->solve, "-") == 0) file = stdin;
+		else{
+			file = fopen(options->solve, "rb");
+			if(file == NULL){
+				fprintf(stderr, "Error: File doesn't exist or cannot be opened\n");
+				return false;
+			}
+		}
+		success = open_scanner(file, &input);
+		if(file != stdin) fclose(file);
+		if(! success) return false;
+	}
+	
+	context.cell_w = context.cell_h = 0;
+	context.pool = NULL;
+	context.solver = NULL;
+	
+	if(result == 1){
+		success = solve_store(options, &context, &store, &puzzles);
+		close_store(&store);
+	}
+	else{
+		success = solve_input(options, &context, &input, &puzzles);
+		close_scanner(&input);
+	}
+	
+	clear_solve_context(&context);
+	
+	fprintf(stderr, "%d puzzles in %.3f seconds of processor time\n", puzzles, (double)(clock() - start) / CLOCKS_PER_SEC);
+	return success;
+}
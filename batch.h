@@ -0,0 +1,39 @@
+#ifndef _BATCH_H
+#define _BATCH_H
+/*
+batch module
+non interactive modes, working on many puzzles without printing boards
+*/
+
+#include "game_main.h"
+
+/*
+generates options->generate puzzles of options->cell_w x options->cell_h blocks,
+as generate command with options->add and options->remain, using given generate options
+
+puzzles are generated by options->threads workers,
+and written in order to options->output (standard output if NULL) in saved game format, one after another,
+or as a packed container if output file name has packed extension (see packed module)
+
+puzzle i uses random stream i of options->seed, so output is the same for a seed regardless of number of workers
+
+returns whether successful (puzzles generator failed on are skipped)
+*/
+bool batch_generate(Options* options, GenOptions* gen);
+
+/*
+solves all puzzles of options->solve ("-" for standard input), which is either
+puzzles in saved game format one after another, a packed container, or names of saved game files, one per line
+packed container files are mapped to memory (see store module), and their puzzles are used in place
+
+for each puzzle, writes to standard output its solution in saved game format, or a line "unsolvable"
+if options->count is set, writes a line with number of solutions instead (see count_solutions),
+counting up to options->count_limit solutions with options->threads threads
+
+writes number of puzzles and processor time to standard error
+
+returns whether successful
+*/
+bool batch_solve(Options* options);
+
+#endif
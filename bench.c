@@ -0,0 +1,282 @@
+/*
+benchmark program
+runs solver, solution counter, autofill and generator over puzzle corpora (see corpora directory),
+and writes latency percentiles and throughput of each operation as tab separated values
+*/
+
+#include "game_adv.h"
+
+#include <stdlib.h> /* allocation functions */
+#include <stdio.h>
+#include <string.h>
+#include <time.h> /* clock */
+
+/*
+seed of random streams used by generator, fixed so runs are comparable
+*/
+#define BENCH_SEED 2018UL
+
+/*
+puzzles of a single corpus file, all of the same dimensions
+*/
+typedef struct corpus_struct{
+	char* name;
+	int cell_w, cell_h;
+	Board** puzzles;
+	int num;
+	int clues; /* smallest number of values in a puzzle */
+} Corpus;
+
+/*
+operations measured on each puzzle
+*/
+typedef enum operation_enum{
+	OPERATION_SOLVE,
+	OPERATION_COUNT,
+	OPERATION_AUTOFILL,
+	OPERATION_GENERATE,
+	OPERATION_KINDS
+} Operation;
+
+char* operation_names[OPERATION_KINDS] = {"solve", "count", "autofill", "generate"};
+
+/*
+frees puzzles of corpus
+*/
+void free_corpus(Corpus* corpus){
+	int i;
+	for(i = 0; i < corpus->num; i++) free_board(corpus->puzzles[i]);
+	free(corpus->puzzles);
+}
+
+/*
+reads all puzzles of file in saved game format, one after another
+returns whether successful
+*/
+bool read_corpus(char* filename, Corpus* corpus){
+	FILE* file;
+	BoardScanner scanner;
+	int result, cell_w, cell_h, capacity = 0;
+	bool success;
+
+	corpus->name = filename;
+	corpus->puzzles = NULL;
+	corpus->num = 0;
+	corpus->clues = -1;
+
+	file = fopen(filename, "r");
+	if(file == NULL){
+		fprintf(stderr, "Error: File %s doesn't exist or cannot be opened\n", filename);
+		return false;
+	}
+	success = open_scanner(file, &scanner);
+	fclose(file);
+	if(! success) return false;
+
+	while((result = scan_dimensions(&scanner, &cell_w, &cell_h)) == 1){
+		Board* board;
+		int x, y, clues = 0, N = cell_w * cell_h;
+
+		if(corpus->num == 0){
+			corpus->cell_w = cell_w;
+			corpus->cell_h = cell_h;
+		}
+		else if(cell_w != corpus->cell_w || cell_h != corpus->cell_h){
+			fprintf(stderr, "Error: puzzles of %s have different dimensions\n", filename);
+			break;
+		}
+
+		if(corpus->num == capacity){
+			Board** puzzles;
+			capacity = capacity ? 2*capacity : 16;
+			puzzles = realloc(corpus->puzzles, capacity * sizeof(Board*));
+			if(puzzles == NULL){
+				fprintf(stderr, "Error: realloc has failed\n");
+				break;
+			}
+			corpus->puzzles = puzzles;
+		}
+
+		board = create_board(cell_w, cell_h);
+		if(board == NULL) break;
+		if(! scan_values(&scanner, board, NULL)){
+			free_board(board);
+			break;
+		}
+		corpus->puzzles[corpus->num++] = board;
+
+		for(y = 0; y < N; y++){
+			for(x = 0; x < N; x++) if(board->table[y][x] != 0) clues++;
+		}
+		if(corpus->clues < 0 || clues < corpus->clues) corpus->clues = clues;
+	}
+
+	close_scanner(&scanner);
+	if(result != 0 || corpus->num == 0){
+		if(corpus->num == 0 && result == 0) fprintf(stderr, "Error: %s has no puzzles\n", filename);
+		free_corpus(corpus);
+		return false;
+	}
+	return true;
+}
+
+/*
+runs operation on puzzle "index" of corpus (generate ignores puzzle, and uses its dimensions and number of values)
+returns whether successful
+*/
+bool run_operation(Operation op, Corpus* corpus, int index, SolverContext* solver, Game* game){
+	Board* puzzle = corpus->puzzles[index];
+	Board* result;
+
+	switch(op){
+	case OPERATION_SOLVE:
+		result = solve_with(solver, puzzle);
+		if(result == NULL) return false;
+		if(result == puzzle){
+			fprintf(stderr, "Error: puzzle %d of %s is unsolvable\n", index + 1, corpus->name);
+			return false;
+		}
+		free_board(result);
+		return true;
+	case OPERATION_COUNT:{
+		WideCount count;
+		bool interrupted = false;
+		if(! count_solutions(puzzle, 1, 0, NULL, &count, &interrupted)) return false;
+		return ! interrupted;
+	}
+	case OPERATION_AUTOFILL:
+		result = autofill(puzzle, true);
+		if(result == NULL) return false;
+		if(result != puzzle) free_board(result);
+		return true;
+	case OPERATION_GENERATE:{
+		GenOptions options;
+		Random rng;
+		options.unique = true;
+		options.symmetric = false;
+		options.difficulty = DIFFICULTY_HARD;
+		seed_random(&rng, BENCH_SEED, index); /* same puzzles on every run */
+
+		result = generate(game, 0, corpus->clues, &options, &rng);
+		if(result == NULL) return false;
+		if(result != game->board) free_board(result);
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+/*
+compares two doubles, for qsort
+*/
+int compare_times(const void* a, const void* b){
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+/*
+returns "p" percentile (nearest rank) of sorted times
+*/
+double percentile(double* times, int num, int p){
+	int rank = (p * num + 99) / 100; /* round up */
+	return times[rank > 0 ? rank - 1 : 0];
+}
+
+/*
+runs operation on every puzzle of corpus "runs" times, and writes a line of results
+returns whether successful
+*/
+bool bench_operation(Operation op, Corpus* corpus, int runs, SolverContext* solver, Game* game){
+	double* times;
+	double total = 0;
+	int i, num = corpus->num * runs;
+
+	times = calloc(num, sizeof(double));
+	if(times == NULL){
+		fprintf(stderr,"Error: calloc has failed\n");
+		return false;
+	}
+
+	for(i = 0; i < num; i++){
+		clock_t start = clock();
+		if(! run_operation(op, corpus, i % corpus->num, solver, game)){
+			free(times);
+			return false;
+		}
+		times[i] = (double)(clock() - start) / CLOCKS_PER_SEC;
+		total += times[i];
+	}
+
+	qsort(times, num, sizeof(double), compare_times);
+
+	/* latencies in microseconds */
+	printf("%s\t%s\t%dx%d\t%d\t%.6f\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f\n",
+			corpus->name, operation_names[op], corpus->cell_w, corpus->cell_h, num, total,
+			total > 0 ? num / total : 0.0,
+			1e6 * total / num, 1e6 * percentile(times, num, 50), 1e6 * percentile(times, num, 90),
+			1e6 * percentile(times, num, 99), 1e6 * times[num - 1]);
+	fflush(stdout);
+
+	free(times);
+	return true;
+}
+
+/*
+runs all operations on corpus
+returns whether successful
+*/
+bool bench_corpus(Corpus* corpus, int runs){
+	SolverContext* solver;
+	Game* game;
+	int op;
+	bool success = true;
+
+	/* context is created once per corpus, like the game does */
+	solver = create_solver(corpus->cell_w, corpus->cell_h);
+	if(solver == NULL) return false;
+	game = create_game(corpus->cell_w, corpus->cell_h);
+	if(game == NULL){
+		free_solver(solver);
+		return false;
+	}
+
+	for(op = 0; op < OPERATION_KINDS && success; op++){
+		/* generator is slow, so it runs once per puzzle */
+		success = bench_operation(op, corpus, op == OPERATION_GENERATE ? 1 : runs, solver, game);
+	}
+
+	free_game(game);
+	free_solver(solver);
+	return success;
+}
+
+int main(int argc, char** argv){
+	char* name = argv[0];
+	int i, runs = 1;
+	bool success = true;
+
+	if(argc > 2 && strcmp(argv[1], "--runs") == 0){
+		runs = atoi(argv[2]);
+		argv += 2;
+		argc -= 2;
+	}
+	if(argc < 2 || runs < 1){
+		fprintf(stderr, "Usage: %s [--runs <num>] <corpus file>...\n", name);
+		return 1;
+	}
+
+	printf("corpus\toperation\tsize\tsamples\ttotal_s\tper_s\tmean_us\tp50_us\tp90_us\tp99_us\tmax_us\n");
+
+	for(i = 1; i < argc && success; i++){
+		Corpus corpus;
+		if(! read_corpus(argv[i], &corpus)){
+			success = false;
+			break;
+		}
+		success = bench_corpus(&corpus, runs);
+		free_corpus(&corpus);
+	}
+
+	return success ? 0 : 1;
+}
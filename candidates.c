@@ -0,0 +1,135 @@
+#include "candidates.h"
+
+#include <stdlib.h> /* allocation functions */
+#include <stdio.h>
+
+Candidates* create_candidates(Board* board){
+	Candidates* cands;
+	int N = board->cell_w * board->cell_h; /* for convenience and readability */
+	int x,y;
+
+	cands = malloc(sizeof(Candidates));
+	if(cands == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
+		return NULL;
+	}
+
+	cands->cell_w = board->cell_w;
+	cands->cell_h = board->cell_h;
+	cands->words = (N + MASK_WORD_BITS - 1) / MASK_WORD_BITS; /* round up */
+
+	/* rows, columns and blocks, N masks each (set by default to empty) */
+	cands->memory = calloc(3 * N * cands->words, sizeof(MaskWord));
+	if(cands->memory == NULL){
+		fprintf(stderr,"Error: calloc has failed\n");
+		free(cands);
+		return NULL;
+	}
+	cands->rows = cands->memory;
+	cands->cols = cands->rows + N * cands->words;
+	cands->blocks = cands->cols + N * cands->words;
+
+	/* mark all numbers on board */
+	for(y = 0; y < N; y++){
+		for(x = 0; x < N; x++){
+			if(board->table[y][x] != 0) mark_used(cands, x, y, board->table[y][x]);
+		}
+	}
+
+	return cands;
+}
+
+void free_candidates(Candidates* cands){
+	free(cands->memory);
+	free(cands);
+}
+
+int get_block(Candidates* cands, int x, int y){
+	/* board is cell_h blocks wide */
+	return (y / cands->cell_h) * cands->cell_h + x / cands->cell_w;
+}
+
+void mark_used(Candidates* cands, int x, int y, int num){
+	int word = (num-1) / MASK_WORD_BITS; /* position of number in mask */
+	MaskWord bit = (MaskWord)1 << ((num-1) % MASK_WORD_BITS);
+
+	cands->rows[y * cands->words + word] |= bit;
+	cands->cols[x * cands->words + word] |= bit;
+	cands->blocks[get_block(cands, x, y) * cands->words + word] |= bit;
+}
+
+void unmark_used(Candidates* cands, int x, int y, int num){
+	int word = (num-1) / MASK_WORD_BITS; /* position of number in mask */
+	MaskWord bit = (MaskWord)1 << ((num-1) % MASK_WORD_BITS);
+
+	cands->rows[y * cands->words + word] &= ~bit;
+	cands->cols[x * cands->words + word] &= ~bit;
+	cands->blocks[get_block(cands, x, y) * cands->words + word] &= ~bit;
+}
+
+bool is_candidate(Candidates* cands, int x, int y, int num){
+	int word = (num-1) / MASK_WORD_BITS; /* position of number in mask */
+	MaskWord bit = (MaskWord)1 << ((num-1) % MASK_WORD_BITS);
+
+	return !((cands->rows[y * cands->words + word] |
+			cands->cols[x * cands->words + word] |
+			cands->blocks[get_block(cands, x, y) * cands->words + word]) & bit);
+}
+
+int get_candidates(Candidates* cands, int x, int y, MaskWord* mask){
+	int N = cands->cell_w * cands->cell_h;
+	int block = get_block(cands, x, y);
+	int i, count = 0;
+
+	for(i = 0; i < cands->words; i++){
+		MaskWord w;
+		/* numbers not used in row, column or block */
+		mask[i] = ~(cands->rows[y * cands->words + i] |
+				cands->cols[x * cands->words + i] |
+				cands->blocks[block * cands->words + i]);
+
+		/* clear bits above N in last word */
+		if((i+1) * MASK_WORD_BITS > N) mask[i] &= ((MaskWord)1 << (N - i * MASK_WORD_BITS)) - 1;
+
+		for(w = mask[i]; w; w &= w-1) count++; /* count set bits */
+	}
+
+	return count;
+}
+
+bool in_mask(MaskWord* mask, int num){
+	return (mask[(num-1) / MASK_WORD_BITS] >> ((num-1) % MASK_WORD_BITS)) & 1;
+}
+
+void remove_from_mask(MaskWord* mask, int num){
+	mask[(num-1) / MASK_WORD_BITS] &= ~((MaskWord)1 << ((num-1) % MASK_WORD_BITS));
+}
+
+int next_candidate(MaskWord* mask, int words, int num){
+	int i = num / MASK_WORD_BITS, bit = num % MASK_WORD_BITS; /* position of num+1 */
+
+	for(; i < words; i++, bit = 0){
+		MaskWord w = mask[i] >> bit; /* skip numbers up to num */
+		if(w){
+			while(!(w & 1)){
+				w >>= 1;
+				bit++;
+			}
+			return i * MASK_WORD_BITS + bit + 1;
+		}
+	}
+
+	return 0; /* no more numbers */
+}
+
+int count_before(MaskWord* mask, int words, int num){
+	int i, count = 0;
+
+	for(i = 0; i < words && i * MASK_WORD_BITS < num-1; i++){
+		MaskWord w = mask[i];
+		if((i+1) * MASK_WORD_BITS > num-1) w &= ((MaskWord)1 << (num-1 - i * MASK_WORD_BITS)) - 1; /* only bits of smaller numbers */
+		for(; w; w &= w-1) count++; /* count set bits */
+	}
+
+	return count;
+}
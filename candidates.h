@@ -0,0 +1,88 @@
+#ifndef _CANDIDATES_H
+#define _CANDIDATES_H
+/*
+candidates module
+keeps bitsets of numbers used in each row, column and block of a board,
+so legality checks and candidate sets of a position are computed without scanning the board
+*/
+
+#include "game.h"
+
+#include <limits.h> /* CHAR_BIT */
+
+/*
+bitset word, number "num" is bit (num-1)%MASK_WORD_BITS of word (num-1)/MASK_WORD_BITS
+*/
+typedef unsigned long MaskWord;
+
+#define MASK_WORD_BITS ((int)(sizeof(MaskWord) * CHAR_BIT))
+
+/*
+structure saving used numbers of a board
+*/
+typedef struct candidates_struct{
+	int cell_w, cell_h; /* cell width and height of board */
+	int words; /* number of words in a single mask */
+	MaskWord* memory; /* memory for all masks */
+	MaskWord* rows; /* N masks, one per row */
+	MaskWord* cols; /* N masks, one per column */
+	MaskWord* blocks; /* N masks, one per block, blocks are numbered row by row */
+} Candidates;
+
+/*
+creates candidate masks of given board
+board is assumed to have no erroneous values
+
+on error returns NULL
+*/
+Candidates* create_candidates(Board* board);
+
+/*
+frees candidate masks
+*/
+void free_candidates(Candidates* cands);
+
+/*
+returns number of block containing position x,y
+*/
+int get_block(Candidates* cands, int x, int y);
+
+/*
+marks "num" as used/unused in row, column and block of position x,y
+*/
+void mark_used(Candidates* cands, int x, int y, int num);
+void unmark_used(Candidates* cands, int x, int y, int num);
+
+/*
+returns whether "num" can be placed at x,y
+*/
+bool is_candidate(Candidates* cands, int x, int y, int num);
+
+/*
+outputs numbers that can be placed at x,y to "mask" (must have cands->words words)
+
+returns number of such numbers
+*/
+int get_candidates(Candidates* cands, int x, int y, MaskWord* mask);
+
+/*
+returns whether "num" is in "mask"
+*/
+bool in_mask(MaskWord* mask, int num);
+
+/*
+removes "num" from "mask"
+*/
+void remove_from_mask(MaskWord* mask, int num);
+
+/*
+returns smallest number in "mask" that is greater than "num", or 0 if there is none
+*/
+int next_candidate(MaskWord* mask, int words, int num);
+
+/*
+returns number of numbers in "mask" that are smaller than "num"
+*/
+int count_before(MaskWord* mask, int words, int num);
+
+#endif
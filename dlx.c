@@ -0,0 +1,289 @@
+#include "dlx.h"
+#include "stats.h"
+
+#include <stdlib.h> /* allocation functions */
+#include <stdio.h>
+
+/*
+allocates an array of "num" integers
+prints error message on failure
+*/
+int* alloc_ints(int num){
+	int* arr = calloc(num, sizeof(int));
+	if(arr == NULL) fprintf(stderr,"Error: calloc has failed\n");
+	return arr;
+}
+
+DlxMatrix* create_dlx(int cell_w, int cell_h){
+	DlxMatrix* matrix;
+	int N = cell_w*cell_h; /* for convenience and readability */
+	int col_num = 4*N*N; /* number of constraints */
+	int x,y,num,k,node;
+
+	matrix = malloc(sizeof(DlxMatrix));
+	if(matrix == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
+		return NULL;
+	}
+
+	matrix->cell_w = cell_w;
+	matrix->cell_h = cell_h;
+	matrix->node_num = 1 + col_num + 4*N*N*N; /* root, headers and 4 nodes per candidate */
+
+	/* set all to NULL so failure cleanup can free everything */
+	matrix->left = matrix->right = matrix->up = matrix->down = NULL;
+	matrix->column = matrix->size = matrix->chosen = matrix->headers = NULL;
+	matrix->node_limit = 0;
+	matrix->stopped = false;
+	matrix->used = NULL;
+
+	if((matrix->left = alloc_ints(matrix->node_num)) == NULL ||
+			(matrix->right = alloc_ints(matrix->node_num)) == NULL ||
+			(matrix->up = alloc_ints(matrix->node_num)) == NULL ||
+			(matrix->down = alloc_ints(matrix->node_num)) == NULL ||
+			(matrix->column = alloc_ints(matrix->node_num)) == NULL ||
+			(matrix->size = alloc_ints(col_num + 1)) == NULL ||
+			(matrix->chosen = alloc_ints(N*N)) == NULL || /* at most one level per cell */
+			(matrix->headers = alloc_ints(N*N)) == NULL){
+		free_dlx(matrix);
+		return NULL;
+	}
+
+	matrix->used = calloc(col_num + 1, sizeof(bool));
+	if(matrix->used == NULL){
+		fprintf(stderr,"Error: calloc has failed\n");
+		free_dlx(matrix);
+		return NULL;
+	}
+
+	/* link root and headers in a circular row */
+	for(k = 0; k <= col_num; k++){
+		matrix->left[k] = (k == 0) ? col_num : k-1;
+		matrix->right[k] = (k == col_num) ? 0 : k+1;
+		matrix->up[k] = matrix->down[k] = matrix->column[k] = k; /* empty column */
+	}
+
+	/* add candidates in order, candidate (x,y,num) has 4 nodes starting at 1+col_num + 4*((y*N + x)*N + num) */
+	node = col_num + 1;
+	for(y = 0; y < N; y++){
+		for(x = 0; x < N; x++){
+			int block = (y / cell_h) * cell_h + x / cell_w; /* board is cell_h blocks wide */
+			for(num = 0; num < N; num++){
+				int cols[4]; /* constraints satisfied by candidate */
+				cols[0] = 1 + y*N + x; /* one number per cell */
+				cols[1] = 1 + N*N + y*N + num; /* one appearance per row */
+				cols[2] = 1 + 2*N*N + x*N + num; /* one appearance per column */
+				cols[3] = 1 + 3*N*N + block*N + num; /* one appearance per block */
+
+				for(k = 0; k < 4; k++, node++){
+					int c = cols[k];
+					matrix->column[node] = c;
+					/* insert at bottom of column */
+					matrix->up[node] = matrix->up[c];
+					matrix->down[node] = c;
+					matrix->down[matrix->up[c]] = node;
+					matrix->up[c] = node;
+					matrix->size[c]++;
+					/* circular row of 4 nodes */
+					matrix->left[node] = (k == 0) ? node+3 : node-1;
+					matrix->right[node] = (k == 3) ? node-3 : node+1;
+				}
+			}
+		}
+	}
+
+	return matrix;
+}
+
+void free_dlx(DlxMatrix* matrix){
+	/* free(NULL) does nothing, so partially created matrices can be freed */
+	free(matrix->left);
+	free(matrix->right);
+	free(matrix->up);
+	free(matrix->down);
+	free(matrix->column);
+	free(matrix->size);
+	free(matrix->used);
+	free(matrix->chosen);
+	free(matrix->headers);
+	free(matrix);
+}
+
+/*
+removes column "c" from header list, and all rows intersecting it from their other columns
+*/
+void cover(DlxMatrix* m, int c){
+	int i,j;
+	m->right[m->left[c]] = m->right[c];
+	m->left[m->right[c]] = m->left[c];
+	for(i = m->down[c]; i != c; i = m->down[i]){
+		for(j = m->right[i]; j != i; j = m->right[j]){
+			m->up[m->down[j]] = m->up[j];
+			m->down[m->up[j]] = m->down[j];
+			m->size[m->column[j]]--;
+		}
+	}
+}
+
+/*
+reverts cover of column "c", must be called in reverse order of covers
+*/
+void uncover(DlxMatrix* m, int c){
+	int i,j;
+	for(i = m->up[c]; i != c; i = m->up[i]){
+		for(j = m->left[i]; j != i; j = m->left[j]){
+			m->size[m->column[j]]++;
+			m->up[m->down[j]] = j;
+			m->down[m->up[j]] = j;
+		}
+	}
+	m->right[m->left[c]] = c;
+	m->left[m->right[c]] = c;
+}
+
+/*
+cover all other columns of row of given node
+*/
+void select_row(DlxMatrix* m, int r){
+	int j;
+	for(j = m->right[r]; j != r; j = m->right[j]) cover(m, m->column[j]);
+}
+
+/*
+reverts select_row
+*/
+void unselect_row(DlxMatrix* m, int r){
+	int j;
+	for(j = m->left[r]; j != r; j = m->left[j]) uncover(m, m->column[j]);
+}
+
+/*
+returns uncovered column with fewest rows
+*/
+int choose_column(DlxMatrix* m){
+	int c, best = m->right[0];
+	for(c = m->right[0]; c != 0; c = m->right[c]){
+		if(m->size[c] < m->size[best]){
+			best = c;
+			if(m->size[best] <= 1) break; /* can not do better */
+		}
+	}
+	return best;
+}
+
+bool dlx_solve(DlxMatrix* m, Board* board, Board* out){
+	int N = m->cell_w * m->cell_h; /* for convenience and readability */
+	int col_num = 4*N*N;
+	int x,y,k;
+	int fixed_num = 0; /* number of fixed rows selected */
+	int level = 0; /* search depth */
+	long nodes = 0; /* rows tried */
+	bool conflict = false, found = false;
+
+	m->stopped = false;
+
+	/* select rows of filled cells, stop at first conflict */
+	for(y = 0; y < N && !conflict; y++){
+		for(x = 0; x < N && !conflict; x++){
+			int r,j;
+			if(board->table[y][x] == 0) continue; /* empty cell */
+
+			r = col_num + 1 + 4*((y*N + x)*N + board->table[y][x] - 1); /* first node of candidate */
+
+			for(k = 0, j = r; k < 4; k++, j = m->right[j]){
+				if(m->used[m->column[j]]) conflict = true; /* constraint already satisfied by other cell */
+			}
+			if(conflict) break;
+
+			/* cover constraints of candidate, save in "chosen" so they can be uncovered */
+			for(k = 0, j = r; k < 4; k++, j = m->right[j]){
+				m->used[m->column[j]] = true;
+				cover(m, m->column[j]);
+			}
+			m->chosen[fixed_num++] = r;
+		}
+	}
+
+	if(!conflict){
+		/*
+		each simulated recursive call covers the column with fewest rows and tries its rows in order
+
+		column of each level is saved in "headers", current row in "chosen"
+		*/
+		int* headers = m->headers;
+		int* chosen = m->chosen + fixed_num; /* fixed rows are saved before search levels */
+
+		if(m->right[0] == 0){
+			found = true; /* board is already full */
+		}
+		else{
+			headers[0] = choose_column(m);
+			cover(m, headers[0]);
+			chosen[0] = m->down[headers[0]];
+		}
+
+		while(level >= 0 && !found){
+			if(m->right[0] == 0){
+				found = true; /* all constraints satisfied */
+				break;
+			}
+			if(m->node_limit > 0 && nodes >= m->node_limit){
+				/* restore column of current level, and search levels before it in reverse order */
+				uncover(m, headers[level]);
+				for(k = level - 1; k >= 0; k--){
+					unselect_row(m, chosen[k]);
+					uncover(m, headers[k]);
+				}
+				m->stopped = true;
+				break;
+			}
+			if(chosen[level] == headers[level]){
+				/* all rows of column were tried */
+				uncover(m, headers[level]);
+				level--; /* go back */
+				if(level >= 0){
+					unselect_row(m, chosen[level]);
+					chosen[level] = m->down[chosen[level]]; /* next option */
+				}
+			}
+			else{
+				select_row(m, chosen[level]);
+				nodes++;
+				level++; /* go to next level */
+				if(m->right[0] != 0){
+					headers[level] = choose_column(m);
+					cover(m, headers[level]);
+					chosen[level] = m->down[headers[level]];
+				}
+			}
+		}
+
+		if(found){
+			/* copy fixed cells and fill search levels into output */
+			for(y = 0; y < N; y++) for(x = 0; x < N; x++) set_cell(out, x, y, board->table[y][x]);
+			for(k = 0; k < level; k++){
+				int cand = (chosen[k] - col_num - 1) / 4; /* candidate index of row */
+				set_cell(out, (cand / N) % N, (cand / N) / N, cand % N + 1);
+			}
+
+			/* restore search levels in reverse order */
+			for(k = level - 1; k >= 0; k--){
+				unselect_row(m, chosen[k]);
+				uncover(m, headers[k]);
+			}
+		}
+	}
+
+	STAT_COUNT(STAT_SOLVER_NODES, nodes);
+	
+	/* restore fixed rows in reverse order */
+	while(fixed_num > 0){
+		int j, r = m->chosen[--fixed_num];
+		for(k = 0, j = m->left[r]; k < 4; k++, j = m->left[j]){
+			uncover(m, m->column[j]);
+			m->used[m->column[j]] = false;
+		}
+	}
+
+	return found;
+}
@@ -0,0 +1,57 @@
+#ifndef _DLX_H
+#define _DLX_H
+/*
+dancing links module
+contains an exact cover (algorithm X) solver for sudoku boards
+*/
+
+#include "game.h"
+
+/*
+exact cover matrix for boards of given dimensions
+
+rows of the matrix are the N^3 candidates (x,y,num),
+columns are the 4N^2 constraints (cell, row, column and block)
+
+all arrays are indexed by node, node 0 is the root,
+nodes 1..4N^2 are column headers and the rest are candidate nodes (4 per candidate)
+*/
+typedef struct dlx_matrix{
+	int cell_w, cell_h; /* block dimensions of boards the matrix solves */
+	int node_num; /* number of nodes */
+	int* left; /* horizontal links */
+	int* right;
+	int* up; /* vertical links */
+	int* down;
+	int* column; /* column header of each node */
+	int* size; /* number of nodes in each column (indexed by header node) */
+	bool* used; /* whether column is covered by a fixed cell (indexed by header node) */
+	int* chosen; /* chosen row node per search level */
+	int* headers; /* covered column per search level */
+	
+	long node_limit; /* search stops after trying this many rows, 0 for no limit */
+	bool stopped; /* whether last search was stopped by node limit */
+} DlxMatrix;
+
+/*
+creates matrix for boards with given dimensions
+on error returns NULL
+*/
+DlxMatrix* create_dlx(int cell_w, int cell_h);
+
+/*
+frees matrix memory
+*/
+void free_dlx(DlxMatrix* matrix);
+
+/*
+searches for a solution of "board" and writes it to "out"
+(board and out must have the matrix dimensions, they may be the same board)
+
+returns whether a solution was found, "out" is unchanged if not
+(if search was stopped by node limit, matrix->stopped is set and board might still have a solution)
+matrix is restored to its initial state on return so it can be reused
+*/
+bool dlx_solve(DlxMatrix* matrix, Board* board, Board* out);
+
+#endif
@@ -1,122 +1,244 @@
 #include "game.h"
+#include "solver.h" /* freeing solver context of game */
+#include "stats.h"
+#include "packed.h" /* binary saved games */
 
 #include <stdio.h>
 #include <stdlib.h> /* for allocation functions */
+#include <string.h> /* memcpy, memset */
+#include <ctype.h> /* scanning saved games */
 
-Board* create_board(int cell_w, int cell_h){
-	Board* new_board;
-	int i; /* index for for loops */
+/*
+type with the strictest alignment needed by a board
+*/
+typedef union board_align{
+	long l;
+	double d;
+	void* p;
+} BoardAlign;
+
+/*
+returns size of a board allocation with given dimensions (rounded up for alignment)
+*/
+size_t board_size(int cell_w, int cell_h){
+	int N = cell_w * cell_h;
+	/* structure, followed by N row pointers, N*N cells and 3 N*N counters */
+	size_t size = sizeof(Board) + N * sizeof(unsigned char*) + 4 * N * N;
+	return (size + sizeof(BoardAlign) - 1) / sizeof(BoardAlign) * sizeof(BoardAlign);
+}
+
+/*
+number of boards in a pool slab
+*/
+#define BOARDS_PER_SLAB 8
+
+BoardPool* create_board_pool(int cell_w, int cell_h){
+	BoardPool* pool;
 	
-	/* allocate board structure */
-	new_board = malloc(sizeof(Board));
-	if(new_board == NULL){
-		fprintf(stderr,"Error: malloc has failed\n");
-		return NULL; /* return null pointer on failure */
+	if(cell_w * cell_h < 1 || cell_w * cell_h > MAX_BOARD_SIZE){
+		fprintf(stderr,"Error: board size must be between 1 and %d\n", MAX_BOARD_SIZE);
+		return NULL;
 	}
 	
-	new_board->cell_w = cell_w;
-	new_board->cell_h = cell_h;
-	
-	/* allocate board memory: cell_w * cell_h rows and columns of integers (set by default to 0) */
-	new_board->memory = calloc(cell_w * cell_w * cell_h * cell_h, sizeof(int));
-	if(new_board->memory == NULL){ /* failure */
-		fprintf(stderr,"Error: calloc has failed\n");
-		free(new_board);
+	pool = malloc(sizeof(BoardPool));
+	if(pool == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
 		return NULL;
 	}
 	
-	/* allocate pointers to cell_w*cell_h rows */
-	new_board->table = calloc(cell_w * cell_h, sizeof(int*));
+	pool->cell_w = cell_w;
+	pool->cell_h = cell_h;
+	pool->free_boards = NULL;
+	pool->slabs = NULL;
+	return pool;
+}
+
+void free_board_pool(BoardPool* pool){
+	while(pool->slabs){
+		void* next = *(void**)pool->slabs; /* slab starts with pointer to next slab */
+		free(pool->slabs);
+		pool->slabs = next;
+	}
+	free(pool);
+}
+
+/*
+allocates board with given dimensions from given pool (or on its own if pool is NULL)
+board memory is not initialized
+*/
+Board* alloc_board(int cell_w, int cell_h, BoardPool* pool){
+	Board* new_board;
+	int N = cell_w * cell_h; /* for convenience and readability */
+	int i; /* index for for loops */
 	
-	if(new_board->table == NULL){ /* failure */
-		fprintf(stderr,"Error: calloc has failed\n");
-		free(new_board->memory);
-		free(new_board);
-		return NULL;
+	if(pool == NULL){
+		if(N < 1 || N > MAX_BOARD_SIZE){
+			fprintf(stderr,"Error: board size must be between 1 and %d\n", MAX_BOARD_SIZE);
+			return NULL;
+		}
+		
+		new_board = malloc(board_size(cell_w, cell_h));
+		if(new_board == NULL){
+			fprintf(stderr,"Error: malloc has failed\n");
+			return NULL; /* return null pointer on failure */
+		}
+	}
+	else{
+		if(pool->free_boards == NULL){
+			/* allocate new slab, first aligned position keeps pointer to next slab */
+			char* slab = malloc(sizeof(BoardAlign) + BOARDS_PER_SLAB * board_size(cell_w, cell_h));
+			if(slab == NULL){
+				fprintf(stderr,"Error: malloc has failed\n");
+				return NULL;
+			}
+			*(void**)slab = pool->slabs;
+			pool->slabs = slab;
+			
+			/* add boards of slab to free list */
+			for(i = 0; i < BOARDS_PER_SLAB; i++){
+				Board* b = (Board*)(slab + sizeof(BoardAlign) + i * board_size(cell_w, cell_h));
+				b->next_free = pool->free_boards;
+				pool->free_boards = b;
+			}
+		}
+		new_board = pool->free_boards;
+		pool->free_boards = new_board->next_free;
 	}
 	
+	new_board->cell_w = cell_w;
+	new_board->cell_h = cell_h;
+	new_board->pool = pool;
+	new_board->next_free = NULL;
+	new_board->table = (unsigned char**)(new_board + 1);
+	new_board->memory = (unsigned char*)(new_board->table + N);
+	new_board->row_counts = new_board->memory + N*N;
+	new_board->col_counts = new_board->row_counts + N*N;
+	new_board->block_counts = new_board->col_counts + N*N;
+	
 	/* set row pointers */
-	for(i = 0; i<cell_w*cell_h; i++){
+	for(i = 0; i<N; i++){
 		/* i'th row starts at i*cell_w*cell_h (cell_w*cell_h cells in a row */
-		new_board->table[i] = new_board->memory + i*cell_w*cell_h;
+		new_board->table[i] = new_board->memory + i*N;
 	}
 	
 	return new_board;
 }
 
+/*
+sets all positions of board to empty
+*/
+void clear_board(Board* board){
+	memset(board->memory, 0, 4 * board->cell_w * board->cell_w * board->cell_h * board->cell_h); /* all positions empty, all counters 0 */
+	board->filled = board->errors = 0;
+}
+
+Board* create_board(int cell_w, int cell_h){
+	Board* new_board = alloc_board(cell_w, cell_h, NULL);
+	
+	if(new_board == NULL) return NULL; /* return null pointer on failure */
+	
+	clear_board(new_board);
+	return new_board;
+}
+
+Board* create_pool_board(BoardPool* pool){
+	Board* new_board = alloc_board(pool->cell_w, pool->cell_h, pool);
+	
+	if(new_board == NULL) return NULL; /* return null pointer on failure */
+	
+	clear_board(new_board);
+	return new_board;
+}
+
 void free_board(Board* board){
-	free(board->memory);
-	free(board->table);
-	free(board);
+	if(board->pool){
+		/* keep for reuse */
+		board->next_free = board->pool->free_boards;
+		board->pool->free_boards = board;
+	}
+	else{
+		free(board); /* single allocation */
+	}
 }
 
-Board* copy_board(Board* board){
+Board* copy_board_to(Board* board, BoardPool* pool){
 	Board* new_board;
-	int x,y; /* for iterating over board */
+	STAT_TIMER(start)
 	
 	/* create board of same dimensions */
-	new_board = create_board(board->cell_w, board->cell_h);
+	new_board = alloc_board(board->cell_w, board->cell_h, pool);
 	
 	if(new_board == NULL) return NULL; /* return null pointer on failure */
 	
-	for(x = 0; x<board->cell_w*board->cell_h; x++){ /* columns */
-		for(y = 0; y<board->cell_w*board->cell_h; y++){ /* rows */
-			new_board->table[y][x] = board->table[y][x]; /* copy values */
-		}
-	}
+	/* copy values and counters, they are a single block */
+	memcpy(new_board->memory, board->memory, 4 * board->cell_w * board->cell_w * board->cell_h * board->cell_h);
+	new_board->filled = board->filled;
+	new_board->errors = board->errors;
 	
+	STAT_TIME(STAT_COPY_BOARD, start);
 	return new_board;
 }
 
+Board* copy_board(Board* board){
+	return copy_board_to(board, board->pool);
+}
 
-bool check_position(Board* board, int x, int y){
-	int ix,iy; /* for iterating over board */
-	int cell_x, cell_y;/* position of cell of x,y */
-	
-	if( board->table[y][x] == 0) return false; /* no errors in empty cell */
-	
-	/* check row */ 
-	for(ix = 0; ix < board->cell_w*board->cell_h; ix++){
-		if(board->table[y][x] == board->table[y][ix] && x != ix){
-			return true; /* error found */
-		}
-	}
 
-	
-	/* check column */ 
-	for(iy = 0; iy < board->cell_w*board->cell_h; iy++){
-		if(board->table[y][x] == board->table[iy][x] && y != iy){
-			return true; /* error found */
-		}
+int get_block_index(Board* board, int x, int y){
+	return (y / board->cell_h) * board->cell_h + x / board->cell_w; /* board is cell_h blocks wide */
+}
+
+void set_cell(Board* board, int x, int y, int z){
+	int N = board->cell_w * board->cell_h;
+	int block = get_block_index(board, x, y);
+	int old = board->table[y][x];
+	
+	if(old == z) return; /* nothing to change */
+	
+	if(old != 0){
+		/* remove old value, pair stops being an error when it drops to one appearance */
+		if(--board->row_counts[y*N + old-1] == 1) board->errors--;
+		if(--board->col_counts[x*N + old-1] == 1) board->errors--;
+		if(--board->block_counts[block*N + old-1] == 1) board->errors--;
+		board->filled--;
 	}
-	
-	cell_x = (x / board->cell_w) * board->cell_w; /* round x to closest cell_w multiple below */
-	cell_y = (y / board->cell_h) * board->cell_h; /* round y to closest cell_h multiple below */
-	
-	/* check cell */
-	for(ix = cell_x; ix < cell_x + board->cell_w; ix++){
-		for(iy = cell_y; iy < cell_y + board->cell_h; iy++){
-			if(board->table[y][x] == board->table[iy][ix] && !(x == ix && y == iy)){
-				return true; /* error found */
-			}
-		}
+	if(z != 0){
+		/* add new value, pair becomes an error when it reaches two appearances */
+		if(++board->row_counts[y*N + z-1] == 2) board->errors++;
+		if(++board->col_counts[x*N + z-1] == 2) board->errors++;
+		if(++board->block_counts[block*N + z-1] == 2) board->errors++;
+		board->filled++;
 	}
 	
-	return false; /* no errors found */
+	board->table[y][x] = z;
 }
 
-bool check_board(Board* board){
-	int x,y; /* position in board */
-	
-	for(x = 0; x < board->cell_w*board->cell_h; x++){
-		for(y = 0; y < board->cell_w*board->cell_h; y++){
-			if(check_position(board, x, y)){
-				return true; /* error found */
-			}
-		}
-	}
+bool is_legal_value(Board* board, int x, int y, int z){
+	int N = board->cell_w * board->cell_h;
+	int self = board->table[y][x] == z ? 1 : 0; /* appearance of z in position itself */
 	
-	return false; /* no errors found */
+	return board->row_counts[y*N + z-1] == self &&
+			board->col_counts[x*N + z-1] == self &&
+			board->block_counts[get_block_index(board, x, y)*N + z-1] == self;
+}
+
+bool check_position(Board* board, int x, int y){
+	int N = board->cell_w * board->cell_h;
+	int z = board->table[y][x];
+	bool error;
+	STAT_TIMER(start)
+	
+	/* no errors in empty cell, otherwise erroneous if its value appears again in its row, column or block */
+	error = z != 0 && (board->row_counts[y*N + z-1] > 1 ||
+			board->col_counts[x*N + z-1] > 1 ||
+			board->block_counts[get_block_index(board, x, y)*N + z-1] > 1);
+	
+	STAT_TIME(STAT_CHECK_POSITION, start);
+	return error;
+}
+
+bool check_board(Board* board){
+	return board->errors > 0;
 }
 
 /*
@@ -125,7 +247,7 @@ print a change in the board given coordinates and values
 value at coordinate x,y is changed from z1 to z2
 */
 void print_change(int x, int y, int z1, int z2, ChangeType t){
-	char s1[3],s2[3]; /* strings for z1,z2 respectively */
+	char s1[4],s2[4]; /* strings for z1,z2 respectively */
 	sprintf(s1,"%d",z1); /* convert */
 	if(z1==0){s1[0] = '_'; s1[1] = '\0';} /* _ for empty cell */
 	sprintf(s2,"%d",z2); /* convert */
@@ -143,15 +265,18 @@ void print_change(int x, int y, int z1, int z2, ChangeType t){
 	}
 }
 
-void print_changes(Board* first, Board* second, ChangeType t){
-	int x,y; /* position on board */
+void print_changes(MoveListNode* move, ChangeType t){
+	int i;
 	
-	/* go over board */
-	for(y = 0; y < first->cell_w*first->cell_h; y++){
-		for(x = 0; x < first->cell_w*first->cell_h; x++){
-			if(first->table[y][x] != second->table[y][x]){ /* changed */
-				print_change(x,y,first->table[y][x],second->table[y][x], t);
-			}
+	/* go over changes, unchanged positions are skipped */
+	for(i = 0; i < move->change_num; i++){
+		Change* c = move->changes + i;
+		if(c->old_value == c->new_value) continue;
+		if(t == CHANGE_UNDO){
+			print_change(c->x, c->y, c->new_value, c->old_value, t); /* backwards */
+		}
+		else{
+			print_change(c->x, c->y, c->old_value, c->new_value, t);
 		}
 	}
 }
@@ -159,14 +284,16 @@ void print_changes(Board* first, Board* second, ChangeType t){
 int count_empty_places(Board* board, int* xs, int* ys){
 	int count=0,x,y;
 	
+	if(xs == NULL || ys == NULL){
+		return board->cell_w * board->cell_w * board->cell_h * board->cell_h - board->filled; /* positions not needed */
+	}
+	
 	/* go over board */
 	for(y = 0; y < board->cell_w * board->cell_h; y++){
 		for(x = 0; x < board->cell_w * board->cell_h; x++){
 			if(board->table[y][x] == 0){
-				if(xs != NULL && ys != NULL){
-					xs[count] = x;
-					ys[count] = y;
-				}
+				xs[count] = x;
+				ys[count] = y;
 				count++;
 			}
 		}
@@ -183,51 +310,69 @@ int count_legal_values(Board* board, int x, int y, int* z){
 	}
 	/* go over all numbers */
 	for(num=1; num <= board->cell_w*board->cell_h; num++){
-		board->table[y][x] = num;
-		if(! check_position(board,x,y)){ /* check if value is legal */
-			z[count] = num;
+		if(is_legal_value(board, x, y, num)){
+			if(z != NULL) z[count] = num;
 			count++;
 		}
 	}
-	board->table[y][x] = 0; /* reset back to empty */
 	return count;
 }
 
-BoardListNode* create_board_node(){
-	BoardListNode* node; /* new node */
+MoveListNode* create_move_node(Arena* arena, int change_num){
+	MoveListNode* node; /* new node */
 	
-	node = malloc(sizeof(BoardListNode));
+	/* changes are allocated right after node */
+	node = arena_alloc(arena, sizeof(MoveListNode) + change_num * sizeof(Change));
 	
-	if(node == NULL){
-		fprintf(stderr,"Error: malloc has failed\n");
-		return NULL; /* return null pointer on failure */
-	}
+	if(node == NULL) return NULL; /* return null pointer on failure */
 	
 	node->next = node->prev = NULL; /* initialize values */
-	node->board = NULL;
+	node->change_num = change_num;
+	node->changes = (Change*)(node + 1);
+	node->end = arena_mark(arena);
+	node->solution = NULL; /* not solved yet */
+	node->unsolvable = false;
 	return node;
 }
 
-void free_board_list(BoardListNode* node){
-	BoardListNode* next; /* next node */
-	
-	/* erase next pointer of previous node if it still leads here */
-	if(node->prev && node->prev->next == node) node->prev->next = NULL; 
-	
-	while(node){ /* loop until end of list */
-		next = node->next; /* save next node */
-		if(node -> board) free_board(node->board); /* delete board if there is one */
-		free(node); /* delete current node */
-		node = next; /* go to next node */
+void apply_move(Board* board, MoveListNode* move){
+	int i;
+	for(i = 0; i < move->change_num; i++){
+		set_cell(board, move->changes[i].x, move->changes[i].y, move->changes[i].new_value);
 	}
 }
 
-void replace_node_board(BoardListNode* node, Board* board){
-	if(node -> board && node->board!=board) free_board(node->board); /* delete old board if it is not the same one */
-	node->board = board;
+void revert_move(Board* board, MoveListNode* move){
+	int i;
+	for(i = move->change_num - 1; i >= 0; i--){ /* reverse order */
+		set_cell(board, move->changes[i].x, move->changes[i].y, move->changes[i].old_value);
+	}
 }
 
 
+/*
+size of undo list arena slabs
+*/
+#define UNDO_SLAB_SIZE 4096
+
+/*
+returns length of separator line of printed board, including newline
+*/
+int separator_length(int cell_w, int cell_h){
+	return (4*cell_w + 1)*cell_h + 2; /* cell_h cells 4*cell_w wide with 1 character separators */
+}
+
+/*
+returns size of buffer of printed board with given dimensions (see print_board)
+*/
+int frame_size(int cell_w, int cell_h){
+	int N = cell_w*cell_h;
+	int cell_chars = N >= 100 ? 5 : 4; /* space, number and type of a position (numbers of 3 digits are wider) */
+	
+	/* cell_w+1 separator lines, and N rows of cell_h cells with separators and newline */
+	return (cell_w + 1) * separator_length(cell_w, cell_h) + N * ((cell_chars*cell_w + 1)*cell_h + 2);
+}
+
 Game* create_game(int cell_w, int cell_h){
 	Game* game;
 	int i;
@@ -240,18 +385,37 @@ Game* create_game(int cell_w, int cell_h){
 		return NULL; /* return NULL on failure */
 	}
 	
-	/* create list of one state */
-	game->undo_list_head = game->undo_list_tail = game->current_state = create_board_node();
+	game->pool = create_board_pool(cell_w, cell_h);
 	
-	if(game->undo_list_head == NULL){
+	if(game->pool == NULL){
+		free(game);
+		return NULL;
+	}
+	
+	game->board = create_pool_board(game->pool);
+	
+	if(game->board == NULL){
+		free_board_pool(game->pool);
 		free(game);
 		return NULL;
 	}
 	
-	game->current_state->board = create_board(cell_w, cell_h);
+	game->arena = create_arena(UNDO_SLAB_SIZE);
 	
-	if(game->current_state->board == NULL){
-		free_board_list(game->undo_list_head);
+	if(game->arena == NULL){
+		free_board(game->board);
+		free_board_pool(game->pool);
+		free(game);
+		return NULL;
+	}
+	
+	/* create list with start of game only */
+	game->undo_list_head = game->undo_list_tail = game->current_state = create_move_node(game->arena, 0);
+	
+	if(game->undo_list_head == NULL){
+		free_arena(game->arena);
+		free_board(game->board);
+		free_board_pool(game->pool);
 		free(game);
 		return NULL;
 	}
@@ -261,7 +425,9 @@ Game* create_game(int cell_w, int cell_h){
 	
 	if(game->memory == NULL){
 		fprintf(stderr,"Error: calloc has failed\n");
-		free_board_list(game->undo_list_head);
+		free_arena(game->arena);
+		free_board(game->board);
+		free_board_pool(game->pool);
 		free(game);
 		return NULL;
 	}
@@ -272,7 +438,9 @@ Game* create_game(int cell_w, int cell_h){
 	if(game->fixed == NULL){
 		fprintf(stderr,"Error: calloc has failed\n");
 		free(game->memory);
-		free_board_list(game->undo_list_head);
+		free_arena(game->arena);
+		free_board(game->board);
+		free_board_pool(game->pool);
 		free(game);
 		return NULL;
 	}
@@ -283,70 +451,202 @@ Game* create_game(int cell_w, int cell_h){
 		game->fixed[i] = game->memory + i*cell_w*cell_h;
 	}
 	
+	/* buffer of printed board, followed by its conflict map */
+	game->frame = malloc(frame_size(cell_w, cell_h) + cell_w*cell_w*cell_h*cell_h*sizeof(bool));
+	
+	if(game->frame == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
+		free(game->fixed);
+		free(game->memory);
+		free_arena(game->arena);
+		free_board(game->board);
+		free_board_pool(game->pool);
+		free(game);
+		return NULL;
+	}
+	game->conflicts = (bool*)(game->frame + frame_size(cell_w, cell_h));
+	
+	game->solver = NULL; /* created on first solve */
+	game->solution = NULL;
+	
 	return game;
 	
 }
 
+/*
+frees solutions kept by given move node and all nodes after it
+*/
+void free_solutions(Game* game, MoveListNode* node){
+	for(; node != NULL; node = node->next){
+		if(node->solution == NULL) continue;
+		if(node->solution == game->solution) game->solution = NULL;
+		free_board(node->solution);
+		node->solution = NULL;
+	}
+}
+
 void free_game(Game* game){
+	if(game->solver) free_solver(game->solver);
+	free_solutions(game, game->undo_list_head);
+	free(game->frame);
 	free(game->fixed);
 	free(game->memory);
-	free_board_list(game->undo_list_head); /* erase all undo list */
+	free_arena(game->arena); /* erase all undo list */
+	free_board(game->board);
+	free_board_pool(game->pool);
 	free(game);
 }
 
-bool add_state(Game* game){
-	/* create new node */
-	game->undo_list_tail->next = create_board_node();
+/*
+removes all moves after current one, their memory is reused by next moves
+*/
+void clear_redo(Game* game){
+	free_solutions(game, game->current_state->next);
 	
-	if(game->undo_list_tail->next == NULL) return false; /* unsuccessful */
+	/* moves after current one were allocated after it */
+	arena_release(game->arena, game->current_state->end);
+	game->current_state->next = NULL;
+	game->undo_list_tail = game->current_state;
+}
+
+/*
+adds given move after current move (which must be last move)
+and applies it to game board
+*/
+void add_move(Game* game, MoveListNode* move){
+	/* connect move to end of undo list */
+	move->prev = game->current_state;
+	game->current_state->next = move;
+	game->undo_list_tail = game->current_state = move;
 	
-	/* connect node back to tail of undo list */
-	game->undo_list_tail->next->prev = game->undo_list_tail;
+	apply_move(game->board, move);
+}
 
-	/* copy last board to new state */
-	game->undo_list_tail->next->board = copy_board(game->undo_list_tail->board);
+bool set_move(Game* game, int x, int y, int z){
+	MoveListNode* move;
 	
-	if(game->undo_list_tail->next->board == NULL){ /* failure */
-		free_board_list(game->undo_list_tail->next); /* delete new node */
-		game->undo_list_tail->next = NULL;
-		return false;
-	}
+	clear_redo(game); /* clear undo list beyond current position */
 	
+	move = create_move_node(game->arena, 1);
+	if(move == NULL) return false; /* unsuccessful */
 	
-	/* mode tail of undo list to new node */
-	game->undo_list_tail = game->undo_list_tail->next;
+	move->changes[0].x = x;
+	move->changes[0].y = y;
+	move->changes[0].old_value = game->board->table[y][x];
+	move->changes[0].new_value = z;
 	
+	add_move(game, move);
+	return true;
+}
+
+bool board_move(Game* game, Board* board){
+	MoveListNode* move;
+	int N = board->cell_w * board->cell_h;
+	int x,y,i=0;
+	
+	/* count changed positions */
+	for(y = 0; y < N; y++) for(x = 0; x < N; x++) if(board->table[y][x] != game->board->table[y][x]) i++;
+	
+	clear_redo(game); /* clear undo list beyond current position */
+	
+	move = create_move_node(game->arena, i);
+	if(move == NULL) return false; /* unsuccessful */
+	
+	/* save changes row by row */
+	for(i = 0, y = 0; y < N; y++){
+		for(x = 0; x < N; x++){
+			if(board->table[y][x] != game->board->table[y][x]){
+				move->changes[i].x = x;
+				move->changes[i].y = y;
+				move->changes[i].old_value = game->board->table[y][x];
+				move->changes[i].new_value = board->table[y][x];
+				i++;
+			}
+		}
+	}
 	
+	add_move(game, move);
 	return true;
 }
 
-void print_seperator_line(Game* game){
-	int cell_w,cell_h,i;
+bool undo_move(Game* game){
+	if(game->current_state->prev == NULL) return false; /* at start of game */
+	
+	revert_move(game->board, game->current_state);
+	game->current_state = game->current_state->prev; /* move back */
+	return true;
+}
+
+bool redo_move(Game* game){
+	if(game->current_state->next == NULL) return false; /* at last move */
+	
+	game->current_state = game->current_state->next; /* move forward */
+	apply_move(game->board, game->current_state);
+	return true;
+}
+
+void reset_game(Game* game){
+	while(undo_move(game)); /* revert all moves */
+	
+	clear_redo(game); /* shrink undo list to first state */
+}
+
+/*
+writes separator line of printed board to "pos"
+returns position after it
+*/
+char* write_seperator_line(Game* game, char* pos){
+	int len = separator_length(game->board->cell_w, game->board->cell_h);
 	
-	/* save cell width and height (for convenience and readability) */
-	cell_w = game->current_state->board->cell_w;
-	cell_h = game->current_state->board->cell_h;
+	memset(pos, '-', len - 1);
+	pos[len - 1] = '\n';
+	return pos + len;
+}
+
+/*
+fills game's conflict map with erroneous positions of board, using counts of board
+*/
+void mark_conflicts(Game* game){
+	Board* board = game->board;
+	int N = board->cell_w * board->cell_h;
+	int x,y;
 	
-	for(i = 0; i<(4*cell_w + 1)*cell_h + 1; i++) printf("-"); /* cell_h cells 4*cell_w wide with 1 character separators */
+	if(board->errors == 0){
+		memset(game->conflicts, false, N*N*sizeof(bool)); /* nothing to mark */
+		return;
+	}
 	
-	printf("\n");
+	for(y = 0; y < N; y++){
+		for(x = 0; x < N; x++){
+			int z = board->table[y][x];
+			/* erroneous if its value appears again in its row, column or block (as in check_position) */
+			game->conflicts[y*N + x] = z != 0 && (board->row_counts[y*N + z-1] > 1 ||
+					board->col_counts[x*N + z-1] > 1 ||
+					board->block_counts[get_block_index(board, x, y)*N + z-1] > 1);
+		}
+	}
 }
 
 void print_board(Game* game, bool mark_errors){
-	Board* board = game->current_state->board; /* get board */
+	Board* board = game->board; /* get board */
+	int N = board->cell_w * board->cell_h;
 	int x,y; /* position index within cell*/
 	int cell_x, cell_y; /* cell index */
+	char* pos = game->frame; /* end of frame built so far */
+	
+	if(mark_errors) mark_conflicts(game);
 	
-	print_seperator_line(game);
+	pos = write_seperator_line(game, pos);
 	
 	for(cell_y = 0; cell_y < board->cell_w; cell_y++){ /* board is cell_w cells high */
 		for(y = 0; y < board->cell_h; y++){ /* cell_h rows in a cell */
-			printf("|"); /* separator */
+			*pos++ = '|'; /* separator */
 			
 			for(cell_x = 0; cell_x < board->cell_h; cell_x++){ /* board is cell_h cell wide */
 				for(x = 0; x < board->cell_w; x++){ /* cell_w columns in a cell */
 					int global_x = x + board->cell_w * cell_x; /* global coordinates of current position */
 					int global_y = y + board->cell_h * cell_y;
+					int z = board->table[global_y][global_x];
 					
 					char type = ' '; /* specifies cell type (.fixed, *erronous,  regular) */
 					
@@ -354,58 +654,311 @@ void print_board(Game* game, bool mark_errors){
 						type = '.'; /* fixed */
 					}
 					/* if erronous and not fixed: mark erronous */
-					if(type == ' ' && mark_errors && check_position(board, global_x, global_y)){
+					if(type == ' ' && mark_errors && game->conflicts[global_y*N + global_x]){
 						type = '*';
 					}
-					printf(" ");
-					if(board->table[global_y][global_x] != 0){
-						printf("%2d",board->table[global_y][global_x]); /* print number */
-					}
-					else{
-						printf("  "); /* empty cell */
-					}
-					printf("%c", type);
+					*pos++ = ' ';
+					/* number, at least 2 characters wide (like "%2d"), or blank if empty */
+					if(z >= 100) *pos++ = '0' + z / 100;
+					*pos++ = z >= 10 ? '0' + (z / 10) % 10 : ' ';
+					*pos++ = z != 0 ? '0' + z % 10 : ' ';
+					*pos++ = type;
 				}
-				printf("|");				
+				*pos++ = '|';
 			}
 			
-			printf("\n"); /* end of line */
+			*pos++ = '\n'; /* end of line */
 		}
-		print_seperator_line(game);
+		pos = write_seperator_line(game, pos);
 	}
+	
+	fwrite(game->frame, sizeof(char), pos - game->frame, stdout);
 }
 
-bool save_board(Game* game, char* filename, bool all_fixed){
-	Board* board = game->current_state->board; /* for convenience */
-	FILE* file = fopen(filename,"w");
-	int x,y;
+/*
+writes non negative number in decimal to "pos"
+returns position after it
+*/
+char* format_number(char* pos, int num){
+	char digits[12]; /* enough for any int */
+	int len = 0;
 	
-	if(file == NULL) return false; /* unsuccessful in opening file */
+	do{
+		digits[len++] = '0' + num % 10;
+		num /= 10;
+	} while(num > 0);
+	
+	while(len > 0) *pos++ = digits[--len]; /* most significant digit first */
+	return pos;
+}
+
+int board_text_size(int cell_w, int cell_h){
+	int N = cell_w*cell_h;
+	/* dimensions line, and N*N values of up to 3 digits, with fixed marker and separator */
+	return 2*12 + N*N*5;
+}
+
+int format_board(char* text, Board* board, bool** fixed){
+	int N = board->cell_w * board->cell_h;
+	int x,y;
+	char* pos = text;
 	
 	/* save cell size */
-	fprintf(file, "%d %d\n", board->cell_h, board->cell_w);
+	pos = format_number(pos, board->cell_h);
+	*pos++ = ' ';
+	pos = format_number(pos, board->cell_w);
+	*pos++ = '\n';
 	
 	/* go over rows */
-	for(y = 0; y < board->cell_w * board->cell_h; y++){
+	for(y = 0; y < N; y++){
 		/* go over columns */
-		for(x = 0; x < board->cell_w * board->cell_h; x++){
-			if(x != 0) fprintf(file, " "); /* separator space */
-			fprintf(file, "%d", board->table[y][x]);
-			/* if all_fixed is true, position is marked fixed if it is not empty */
-			if((all_fixed && board->table[y][x]!=0) || game->fixed[y][x]) fprintf(file, "."); /* mark fixed cells */
+		for(x = 0; x < N; x++){
+			if(x != 0) *pos++ = ' '; /* separator space */
+			pos = format_number(pos, board->table[y][x]);
+			/* without fixed, position is marked fixed if it is not empty */
+			if(fixed == NULL ? board->table[y][x]!=0 : fixed[y][x]) *pos++ = '.'; /* mark fixed cells */
 		}
-		fprintf(file, "\n"); /* end line */
+		*pos++ = '\n'; /* end line */
 	}
 	
+	return pos - text;
+}
+
+bool write_board(FILE* file, Board* board, bool** fixed){
+	char* text = malloc(board_text_size(board->cell_w, board->cell_h));
+	int len;
 	
-	fclose(file);
+	if(text == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
+		return false;
+	}
+	
+	len = format_board(text, board, fixed);
+	if((int)fwrite(text, sizeof(char), len, file) != len){
+		free(text);
+		return false;
+	}
+	
+	free(text);
 	return true;
 }
 
+/*
+suffix of temporary file a board is saved to before replacing saved file
+*/
+#define SAVE_TEMP_SUFFIX ".tmp"
+
+bool save_board(Game* game, char* filename, bool all_fixed){
+	char* temp_name;
+	FILE* file;
+	bool success;
+	
+	/* board is saved to a temporary file, which replaces file only when complete */
+	temp_name = malloc(strlen(filename) + strlen(SAVE_TEMP_SUFFIX) + 1);
+	if(temp_name == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
+		return false;
+	}
+	strcpy(temp_name, filename);
+	strcat(temp_name, SAVE_TEMP_SUFFIX);
+	
+	file = fopen(temp_name,"wb");
+	if(file == NULL){
+		free(temp_name);
+		return false; /* unsuccessful in opening file */
+	}
+	
+	/* if all_fixed is true, all non-empty positions are fixed (whether they are fixed or not) */
+	if(has_packed_extension(filename)){
+		/* container with a single record */
+		PackedWriter writer;
+		success = open_packed_writer(file, &writer);
+		if(success){
+			success = write_packed(&writer, game->board, all_fixed ? NULL : game->fixed);
+			if(! close_packed_writer(&writer)) success = false;
+		}
+	}
+	else success = write_board(file, game->board, all_fixed ? NULL : game->fixed);
+	
+	/* closing flushes the file, so its errors are write errors too */
+	if(fclose(file) != 0) success = false;
+	if(success && rename(temp_name, filename) != 0) success = false;
+	if(! success) remove(temp_name); /* file is left as it was */
+	
+	free(temp_name);
+	return success;
+}
+
+/*
+size of first read of a file, buffer is doubled while file does not fit
+*/
+#define SCANNER_CHUNK 4096
+
+/*
+largest dimension accepted while scanning (larger boards are rejected when created)
+*/
+#define MAX_SCANNED_DIMENSION 1000
+
+bool open_scanner(FILE* file, BoardScanner* scanner){
+	long capacity = SCANNER_CHUNK;
+	
+	scanner->text = malloc(capacity + 1);
+	if(scanner->text == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
+		return false;
+	}
+	scanner->length = 0;
+	
+	/* size of file might not be known (standard input), so read until end */
+	while(true){
+		scanner->length += fread(scanner->text + scanner->length, sizeof(char), capacity - scanner->length, file);
+		if(scanner->length < capacity) break; /* end of file or error */
+		
+		{
+			char* text = realloc(scanner->text, 2*capacity + 1);
+			if(text == NULL){
+				fprintf(stderr,"Error: realloc has failed\n");
+				free(scanner->text);
+				return false;
+			}
+			scanner->text = text;
+			capacity *= 2;
+		}
+	}
+	if(ferror(file)){
+		fprintf(stderr,"Error: fread has failed\n");
+		free(scanner->text);
+		return false;
+	}
+	
+	scanner->text[scanner->length] = '\0'; /* stops scanning at end of text */
+	scanner->pos = scanner->text;
+	scanner->line = 1;
+	return true;
+}
+
+void close_scanner(BoardScanner* scanner){
+	free(scanner->text);
+}
+
+void skip_blanks(BoardScanner* scanner){
+	char* pos = scanner->pos;
+	while(isspace((unsigned char)*pos)){
+		if(*pos == '\n') scanner->line++;
+		pos++;
+	}
+	scanner->pos = pos;
+}
+
+/*
+prints error of malformed text at current position of scanner
+*/
+void scanner_error(BoardScanner* scanner, const char* expected){
+	if(*scanner->pos == '\0') fprintf(stderr, "Error: line %d: expected %s, but file ended\n", scanner->line, expected);
+	else fprintf(stderr, "Error: line %d: expected %s, but found '%c'\n", scanner->line, expected, *scanner->pos);
+}
+
+/*
+scans a non negative number of at most "max", after blank characters
+returns number, or -1 on error (printing error)
+*/
+int scan_number(BoardScanner* scanner, int max, const char* expected){
+	int num = 0;
+	char* pos;
+	
+	skip_blanks(scanner);
+	pos = scanner->pos;
+	if(! isdigit((unsigned char)*pos)){
+		scanner_error(scanner, expected);
+		return -1;
+	}
+	
+	for(; isdigit((unsigned char)*pos); pos++){
+		num = 10*num + (*pos - '0');
+		if(num > max){
+			fprintf(stderr, "Error: line %d: %s is larger than %d\n", scanner->line, expected, max);
+			return -1;
+		}
+	}
+	scanner->pos = pos;
+	return num;
+}
+
+int scan_dimensions(BoardScanner* scanner, int* cell_w, int* cell_h){
+	skip_blanks(scanner);
+	if(*scanner->pos == '\0') return 0; /* no more boards */
+	
+	/* cell height is saved first */
+	if((*cell_h = scan_number(scanner, MAX_SCANNED_DIMENSION, "cell height")) < 0) return -1;
+	if((*cell_w = scan_number(scanner, MAX_SCANNED_DIMENSION, "cell width")) < 0) return -1;
+	if(*cell_w == 0 || *cell_h == 0){
+		fprintf(stderr, "Error: line %d: cell dimensions must be positive\n", scanner->line);
+		return -1;
+	}
+	return 1;
+}
+
+bool scan_values(BoardScanner* scanner, Board* board, bool* fixed){
+	int N = board->cell_w * board->cell_h;
+	int pos;
+	
+	/* saving oreder is same as oreder in memory */
+	for(pos = 0; pos < N*N; pos++){
+		int value = scan_number(scanner, N, "value");
+		if(value < 0) return false;
+		
+		if(*scanner->pos == '.'){
+			if(fixed != NULL) fixed[pos] = true; /* mark position as fixed */
+			scanner->pos++;
+		}
+		/* values are separated by blank characters */
+		if(*scanner->pos != '\0' && ! isspace((unsigned char)*scanner->pos)){
+			scanner_error(scanner, "blank after value");
+			return false;
+		}
+		
+		set_cell(board, pos % N, pos / N, value);
+	}
+	
+	return true;
+}
+
+/*
+loads game from first record of packed container in memory
+if use_fixed is false: does not load whether cells are fixed
+*/
+Game* load_packed_game(const unsigned char* data, long length, bool use_fixed){
+	PackedView view;
+	const unsigned char* record;
+	long record_length;
+	int cell_w, cell_h;
+	Game* game;
+	
+	if(! open_packed_view(data, length, &view)) return NULL;
+	if(view.count == 0){
+		fprintf(stderr, "Error: file is empty\n");
+		return NULL;
+	}
+	
+	record = packed_record(&view, 0, &record_length);
+	if(! record_dimensions(record, record_length, &cell_w, &cell_h)) return NULL;
+	
+	game = create_game(cell_w, cell_h);
+	if(game == NULL) return NULL; /* unsuccessful allocation */
+	
+	if(! unpack_board(record, game->board, use_fixed ? game->memory : NULL)){
+		free_game(game);
+		return NULL;
+	}
+	return game;
+}
+
 Game* load_board(char* filename, bool use_fixed){
 	Game* game;
-	int cell_w, cell_h,pos;
-	FILE* file = fopen(filename, "r");
+	BoardScanner scanner;
+	int cell_w, cell_h, result;
+	bool success;
+	FILE* file = fopen(filename, "rb"); /* might be packed */
 	
 	if(file == NULL){
 		/* there are different errors for edit(use_fixed) and solve(!use_fixed) */
@@ -413,38 +966,43 @@ Game* load_board(char* filename, bool use_fixed){
 		return NULL; /* unsuccessful in opening file */
 	}
 	
-	if(fscanf(file, "%d%d", &cell_h, &cell_w) != 2){
-		fprintf(stderr, "Error: fscanf has failed\n");
-		fclose(file);
+	/* whole file is read at once, and parsed from memory */
+	success = open_scanner(file, &scanner);
+	fclose(file);
+	if(! success) return NULL;
+	
+	if(is_packed((unsigned char*)scanner.text, scanner.length)){
+		game = load_packed_game((unsigned char*)scanner.text, scanner.length, use_fixed);
+		close_scanner(&scanner);
+		return game;
+	}
+	
+	result = scan_dimensions(&scanner, &cell_w, &cell_h);
+	if(result != 1){
+		if(result == 0) fprintf(stderr, "Error: file is empty\n");
+		close_scanner(&scanner);
 		return NULL;
 	}
 
 	game = create_game(cell_w, cell_h);
 	
 	if(game == NULL){
-		fclose(file);
+		close_scanner(&scanner);
 		return NULL; /* unsuccessful allocation */
 	}
 	
-	
-	/* saving oreder is same as oreder in memory */
-	for(pos = 0; pos < cell_w * cell_h * cell_w * cell_h; pos++){
-		char fixed_marker;
-		if(fscanf(file,"%d%c", (game->current_state->board->memory) + pos, &fixed_marker) != 2){ /* get number and character after it (could be fixed marker) */
-			fprintf(stderr, "Error: fscanf has failed\n");
-			free_game(game);
-			fclose(file);
-			return NULL;
-		}
-		
-		if(use_fixed && fixed_marker == '.') game->memory[pos] = true; /* mark position as fixed */ 
+	if(! scan_values(&scanner, game->board, use_fixed ? game->memory : NULL)){
+		free_game(game);
+		close_scanner(&scanner);
+		return NULL;
 	}
 	
+	close_scanner(&scanner);
 	return game;
 }
 
 int get_game_size(Game* game){
-	Board* b = game->current_state->board;
+	Board* b = game->board;
 	return b->cell_w * b->cell_h;
 }
 
@@ -9,58 +9,111 @@ remark: cell here and in source file for this header means block
 */
 
 #include <stdbool.h> /* boolean type */
+#include <limits.h> /* UCHAR_MAX */
+#include <stdio.h> /* FILE */
+
+#include "arena.h"
+
+/*
+maximal board size (cell_w*cell_h), every position is kept in a single byte
+*/
+#define MAX_BOARD_SIZE UCHAR_MAX
 
 /*
 structure for saving a game board
+
+structure, row pointers, board memory and counters are kept in a single allocation
+
+board must only be changed using set_cell, which keeps counters up to date
 */
 typedef struct sudoku_board{
 	int cell_w, cell_h; /* cell width and height */
 	/* note board is cell_h cells wide and cell_w cells high */
-	int* memory; /* memory to keep board: row by row */
-	int** table; /* array of pointers to rows */
+	unsigned char* memory; /* memory to keep board: row by row */
+	unsigned char** table; /* array of pointers to rows */
+	
+	/* appearances of each number in each row, column and block: counts[i*N + num-1] for i'th row/column/block */
+	unsigned char* row_counts;
+	unsigned char* col_counts;
+	unsigned char* block_counts; /* blocks are numbered row by row */
+	int filled; /* number of non empty positions */
+	int errors; /* number of (row/column/block, number) pairs where number appears more than once */
+	
+	struct board_pool* pool; /* pool board belongs to, NULL if allocated on its own */
+	struct sudoku_board* next_free; /* next free board of pool (while board is free) */
 }Board;
 
+/*
+pool of boards with the same dimensions
+boards are allocated in slabs, and freed boards are kept for reuse
+*/
+typedef struct board_pool{
+	int cell_w, cell_h; /* dimensions of boards */
+	Board* free_boards; /* list of free boards */
+	void* slabs; /* list of slabs, each starts with pointer to next one */
+} BoardPool;
+
+/*
+creates pool for boards of given dimensions
+on error returns NULL
+*/
+BoardPool* create_board_pool(int cell_w, int cell_h);
+/*
+frees pool with all its slabs, all boards of pool must be freed already
+*/
+void free_board_pool(BoardPool* pool);
+
 /*
 creates board with given dimensions
+on error (including too large dimensions) returns NULL
 */
 Board* create_board(int cell_w, int cell_h);
 /*
-frees board memory
+creates empty board from given pool
+on error returns NULL
+*/
+Board* create_pool_board(BoardPool* pool);
+/*
+frees board memory (returns it to its pool)
 */
 void free_board(Board* board);
 /*
-creates copy of given board
+creates copy of given board, in same pool as given board
 */
 Board* copy_board(Board* board);
-
 /*
-check if position is erroneous
-returns 1 if it is and 0 if it isn't
+creates copy of given board in given pool (or on its own if pool is NULL)
+pools are not thread safe, boards used by other threads should not be from a pool
 */
-bool check_position(Board* board, int x, int y);
+Board* copy_board_to(Board* board, BoardPool* pool);
 
 /*
-check if any position is erroneous in given board
+returns number of block containing position x,y (blocks are numbered row by row)
 */
-bool check_board(Board* board);
+int get_block_index(Board* board, int x, int y);
 
+/*
+sets position x,y of board to z (0 for empty)
+*/
+void set_cell(Board* board, int x, int y, int z);
 
 /*
-possible types of changes, used to determine print format (see next function)
+returns whether z (non zero) can be put in position x,y without creating an error
+(value currently at x,y is ignored)
 */
-typedef enum change_type_enum{
-	CHANGE_UNDO,CHANGE_REDO, CHANGE_SET
-} ChangeType;
+bool is_legal_value(Board* board, int x, int y, int z);
 
 /*
-prints all changes made to go from first board to second
+check if position is erroneous
+returns 1 if it is and 0 if it isn't
+*/
+bool check_position(Board* board, int x, int y);
 
-use change-type to determine how printing should be done
-(Undo x,y: from z1 to z2)
-(Redo x,y: from z1 to z2)
-(Cell <x,y>: set to z)
+/*
+check if any position is erroneous in given board
 */
-void print_changes(Board* first, Board* second, ChangeType t);
+bool check_board(Board* board);
+
 
 /*
 returns number of empty places in given board
@@ -83,44 +136,80 @@ int count_legal_values(Board* board, int x, int y, int* z);
 
 
 /*
-doubly linked list node containing a board;
+possible types of changes, used to determine print format (see print_changes)
+*/
+typedef enum change_type_enum{
+	CHANGE_UNDO,CHANGE_REDO, CHANGE_SET
+} ChangeType;
+
+/*
+change of a single position
+*/
+typedef struct board_change{
+	unsigned char x, y; /* position */
+	unsigned char old_value, new_value; /* value before and after change (0 for empty) */
+} Change;
+
+/*
+doubly linked list node containing the changes made by a single move
 */
-typedef struct board_linked_node{
-	struct board_linked_node* next;
-	struct board_linked_node* prev;
-	Board* board;
-} BoardListNode;
+typedef struct move_linked_node{
+	struct move_linked_node* next;
+	struct move_linked_node* prev;
+	int change_num; /* number of changes */
+	Change* changes; /* changes ordered row by row, allocated together with node */
+	ArenaMark end; /* arena position after node, releasing to it frees all following nodes */
+	
+	Board* solution; /* solution of board after move, NULL if not known */
+	bool unsolvable; /* whether board after move is known to have no solution */
+} MoveListNode;
 
 /*
-create a single board node with a null board pointer
+create a move node with room for "change_num" changes from given arena
+nodes are allocated in list order, so a list suffix is freed by releasing the arena
 */
-BoardListNode* create_board_node();
+MoveListNode* create_move_node(Arena* arena, int change_num);
+
 /*
-free a board node, and all board nodes after it
+applies/reverts all changes of move to board
 */
-void free_board_list(BoardListNode* node);
+void apply_move(Board* board, MoveListNode* move);
+void revert_move(Board* board, MoveListNode* move);
 
 /*
-replace board in given node to given board
+prints all changes of given move
 
-frees old board if it is not null
+use change-type to determine how printing should be done
+(Undo x,y: from z1 to z2) - from value after the move to value before it
+(Redo x,y: from z1 to z2) - from value before the move to value after it
+(Cell <x,y>: set to z)
 */
-void replace_node_board(BoardListNode* node, Board* board);
+void print_changes(MoveListNode* move, ChangeType t);
 
 /*
 state of a sudoku game, intc
 */
 typedef struct game{
-	BoardListNode* undo_list_head; /* start of game */
-	BoardListNode* undo_list_tail; /* last state */
-	BoardListNode* current_state; /* current state of game */
+	Board* board; /* current board */
+	BoardPool* pool; /* pool of game board and its copies */
+	Arena* arena; /* memory of undo list */
+	
+	MoveListNode* undo_list_head; /* start of game, contains no changes */
+	MoveListNode* undo_list_tail; /* last move */
+	MoveListNode* current_state; /* last move applied to board */
 	
 	bool* memory; /* memory saving whether cells are fixed */
 	bool** fixed; /* array of pointers to rows in memory*/
+	
+	struct solver_context* solver; /* solver kept between solves, NULL until first solve */
+	Board* solution; /* last solution found (kept by its move node), NULL if none */
+	
+	char* frame; /* buffer printed board is built in, so it is written at once */
+	bool* conflicts; /* erroneous positions of printed board, row by row (in frame's memory) */
 } Game;
 
 /*
-create game with given cell dimensions and a single state in list
+create game with given cell dimensions and an empty undo list
 */
 Game* create_game(int cell_w, int cell_h);
 
@@ -130,14 +219,55 @@ frees game with it's entire undo list
 void free_game(Game* game);
 
 /*
-adds new state to end of undo list, identical to last
+sets position x,y of game board to z, as a new move
+moves after current one are removed from undo list
+
+returns whether successful
+*/
+bool set_move(Game* game, int x, int y, int z);
+
+/*
+changes game board to given board (of same dimensions), as a new move
+moves after current one are removed from undo list
 
 returns whether successful
 */
-bool add_state(Game* game);
+bool board_move(Game* game, Board* board);
+
+/*
+moves one move back/forward in undo list
+returns false if there is no such move
+*/
+bool undo_move(Game* game);
+bool redo_move(Game* game);
+
+/*
+reverts all moves, and clears undo list
+*/
+void reset_game(Game* game);
+
+/*
+returns size of buffer large enough for text of a board with given dimensions (see format_board)
+*/
+int board_text_size(int cell_w, int cell_h);
 
 /*
-save game state to file
+writes board to "text" in format of saved games (not nullchar terminated)
+positions marked in "fixed" are saved as fixed, if it is NULL all non-empty positions are fixed
+returns length of text
+*/
+int format_board(char* text, Board* board, bool** fixed);
+
+/*
+writes board to open file in format of saved games (see format_board), with a single write
+returns whether successful
+*/
+bool write_board(FILE* file, Board* board, bool** fixed);
+
+/*
+save game state to file, in packed format if file name has packed extension (see packed module)
+board is written to a temporary file (filename with ".tmp" added) which then replaces the file,
+so an interrupted save leaves the file as it was
 
 if all_fixed is true: save all non-empty cells as fixed
 
@@ -145,7 +275,47 @@ returns whether saving is successful (errors in file operations are possible)
 */
 bool save_board(Game* game, char* filename, bool all_fixed);
 /*
-load game state from file
+text of saved games being parsed, read whole from a file
+*/
+typedef struct board_scanner{
+	char* text; /* whole text, ends with nullchar */
+	long length;
+	char* pos; /* next character to parse */
+	int line; /* line of pos, for error messages */
+} BoardScanner;
+
+/*
+reads all of open file (until its end) into scanner, positioned at its start
+returns whether successful, if not prints error
+*/
+bool open_scanner(FILE* file, BoardScanner* scanner);
+
+/*
+frees text of scanner
+*/
+void close_scanner(BoardScanner* scanner);
+
+/*
+advances scanner over blank characters
+*/
+void skip_blanks(BoardScanner* scanner);
+
+/*
+scans board dimensions (first line of saved game format)
+returns 1 on success, 0 if text has no more boards, and -1 on error (printing error with its line)
+*/
+int scan_dimensions(BoardScanner* scanner, int* cell_w, int* cell_h);
+
+/*
+scans values of saved game format into board, after its dimensions were scanned
+positions marked fixed are set in "fixed" (N*N values, row by row), unless it is NULL
+returns whether successful, if not prints error with its line
+*/
+bool scan_values(BoardScanner* scanner, Board* board, bool* fixed);
+
+/*
+load game state from file, saved games in packed format (see packed module) are detected by their header,
+and first board of container is loaded
 
 if use_fixed is false: does not load whether cells are fixed
 */
@@ -153,6 +323,7 @@ Game* load_board(char* filename, bool use_fixed);
 
 /*
 prints board for given game
+whole board is built in game's frame buffer and written with a single call
 
 marks errors if mark_errors!=0
 */
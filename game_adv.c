@@ -1,49 +1,421 @@
 #include "game_adv.h"
+#include "candidates.h"
 
-#include <stdlib.h> /* malloc, rand */
+#include <stdlib.h> /* malloc */
 
 #include <stdio.h>
 
-Board* autofill(Board* board){
+/*
+sets "num" at x,y of board and marks it in candidates
+*/
+void fill_position(Board* board, Candidates* cands, int x, int y, int num){
+	set_cell(board, x, y, num);
+	mark_used(cands, x, y, num);
+}
+
+/*
+kinds of units (rows, columns and blocks), each kind has N units of N positions
+*/
+#define UNIT_ROW 0
+#define UNIT_COL 1
+#define UNIT_BLOCK 2
+#define UNIT_KINDS 3
+
+/*
+outputs position of i'th position of unit to x,y
+blocks are numbered row by row, and their positions as well
+*/
+void unit_position(Board* board, int kind, int unit, int i, int* x, int* y){
+	if(kind == UNIT_ROW){
+		*x = i;
+		*y = unit;
+	}
+	else if(kind == UNIT_COL){
+		*x = unit;
+		*y = i;
+	}
+	else{
+		/* board is cell_h blocks wide */
+		*x = (unit % board->cell_h) * board->cell_w + i % board->cell_w;
+		*y = (unit / board->cell_h) * board->cell_h + i / board->cell_w;
+	}
+}
+
+/*
+fills every number which has a single position in a row, column or block (hidden single)
+"masks" has room for N+1 masks, "counts" and "places" for N values each
+
+returns number of filled positions
+*/
+int fill_hidden_singles(Board* board, Candidates* cands, MaskWord* masks, int* counts, int* places){
+	int N = board->cell_w * board->cell_h;
+	int words = cands->words;
+	MaskWord* mask = masks + N*words; /* candidates of current position */
+	int unit, kind, i, num, filled = 0;
+	
+	for(kind = 0; kind < UNIT_KINDS; kind++){
+		for(unit = 0; unit < N; unit++){
+			for(num = 0; num < N; num++) counts[num] = 0;
+			
+			/* count positions of each number in unit */
+			for(i = 0; i < N; i++){
+				int x,y;
+				unit_position(board, kind, unit, i, &x, &y);
+				
+				if(board->table[y][x] != 0) continue;
+				get_candidates(cands, x, y, mask);
+				for(num = next_candidate(mask, words, 0); num != 0; num = next_candidate(mask, words, num)){
+					counts[num-1]++;
+					places[num-1] = i;
+				}
+			}
+			
+			/* numbers with a single position (which is still a candidate, as earlier fills might have used it) */
+			for(num = 1; num <= N; num++){
+				int x,y;
+				if(counts[num-1] != 1) continue;
+				unit_position(board, kind, unit, places[num-1], &x, &y);
+				if(board->table[y][x] == 0 && is_candidate(cands, x, y, num)){
+					fill_position(board, cands, x, y, num);
+					filled++;
+				}
+			}
+		}
+	}
+	
+	return filled;
+}
+
+Board* autofill(Board* board, bool full){
 	Board* new_board;
-	int* values; /* legal values for position */
+	Candidates* cands; /* numbers used in rows, columns and blocks of new board */
+	MaskWord* masks; /* candidates of all positions, and one extra mask */
+	int* counts; /* for hidden singles, positions of each number in a unit */
+	int* places; /* last position of each number in a unit */
 	int x,y; /* for loops */
 	int N = board->cell_w * board->cell_h;
-	int num_changes = 0;
+	int words;
+	int num_changes = 0, pass_changes;
 	
-	values = calloc(N,sizeof(int));
-	if(values == NULL){
-		fprintf(stderr,"Error: calloc has failed\n");
+	new_board = copy_board(board);
+	if(new_board == NULL) return NULL;
+	
+	cands = create_candidates(board);
+	if(cands == NULL){
+		free_board(new_board);
 		return NULL;
 	}
+	words = cands->words;
 	
-	new_board = copy_board(board);
-	if(new_board == NULL){
-		free(values);
+	/* single block: N*N+1 masks, followed by 2 arrays of N ints */
+	masks = calloc(1, (N*N + 1) * words * sizeof(MaskWord) + 2 * N * sizeof(int));
+	if(masks == NULL){
+		fprintf(stderr,"Error: calloc has failed\n");
+		free_candidates(cands);
+		free_board(new_board);
 		return NULL;
 	}
+	counts = (int*)(masks + (N*N + 1) * words);
+	places = counts + N;
 	
-	/* go over board */
-	for(x=0;x<N;x++) for(y=0;y<N;y++){
-		if(count_legal_values(board,x,y,values) == 1){ /* only one value */
-			num_changes++;
-			new_board->table[y][x] = values[0]; /* set the legal value to new board */
+	do{
+		pass_changes = 0;
+		
+		/* candidates of pass are computed before filling, so values of a pass are obvious on board at pass start */
+		for(y=0;y<N;y++) for(x=0;x<N;x++){
+			if(new_board->table[y][x] == 0) get_candidates(cands, x, y, masks + (y*N + x)*words);
 		}
-	}
+		
+		/* go over board */
+		for(y=0;y<N;y++) for(x=0;x<N;x++){
+			MaskWord* mask = masks + (y*N + x)*words;
+			int num;
+			if(new_board->table[y][x] != 0) continue;
+			num = next_candidate(mask, words, 0);
+			if(num != 0 && next_candidate(mask, words, num) == 0){ /* only one value */
+				/* in full mode keep board legal, a value set earlier in pass might have used the number */
+				if(full && ! is_candidate(cands, x, y, num)) continue;
+				fill_position(new_board, cands, x, y, num); /* set the legal value to new board */
+				pass_changes++;
+			}
+		}
+		
+		/* numbers with a single place */
+		if(full) pass_changes += fill_hidden_singles(new_board, cands, masks, counts, places);
+		
+		num_changes += pass_changes;
+	} while(full && pass_changes > 0); /* repeat until no more deductions */
 	
+	free(masks);
+	free_candidates(cands);
 	
 	if(num_changes == 0){
 		free_board(new_board);
 		new_board = board; /* return the original board if no changes */
 	}
 	
-	free(values);
 	return new_board;
 }
 
+/*
+state of logic deduction: board with deduced values and remaining candidates of every position
+*/
+typedef struct deduction_struct{
+	Board* board; /* board with deduced values */
+	MaskWord* masks; /* candidates of each position (row by row), empty for set positions */
+	int words; /* number of words in a mask */
+	bool contradiction; /* whether deductions showed board has no solution */
+} Deduction;
+
+/*
+returns candidates mask of position x,y
+*/
+MaskWord* deduction_mask(Deduction* d, int x, int y){
+	return d->masks + (y * d->board->cell_w * d->board->cell_h + x) * d->words;
+}
+
+/*
+sets "num" at x,y and removes it from candidates of all positions sharing a unit with x,y
+*/
+void deduce_position(Deduction* d, int x, int y, int num){
+	int N = d->board->cell_w * d->board->cell_h;
+	int kind, i, ux, uy;
+	MaskWord* mask = deduction_mask(d, x, y);
+	
+	set_cell(d->board, x, y, num);
+	for(i = 0; i < d->words; i++) mask[i] = 0;
+	
+	for(kind = 0; kind < UNIT_KINDS; kind++){
+		int unit = kind == UNIT_ROW ? y : kind == UNIT_COL ? x : get_block_index(d->board, x, y);
+		for(i = 0; i < N; i++){
+			unit_position(d->board, kind, unit, i, &ux, &uy);
+			remove_from_mask(deduction_mask(d, ux, uy), num);
+		}
+	}
+}
+
+/*
+removes "num" from candidates of position x,y
+returns whether it was a candidate
+*/
+bool eliminate(Deduction* d, int x, int y, int num){
+	MaskWord* mask = deduction_mask(d, x, y);
+	if(! in_mask(mask, num)) return false;
+	remove_from_mask(mask, num);
+	return true;
+}
+
+/*
+fills positions with a single candidate (naked singles)
+returns whether any change was made
+*/
+bool deduce_naked_singles(Deduction* d){
+	int N = d->board->cell_w * d->board->cell_h;
+	int x, y, num;
+	bool changed = false;
+	
+	for(y = 0; y < N; y++) for(x = 0; x < N; x++){
+		MaskWord* mask = deduction_mask(d, x, y);
+		if(d->board->table[y][x] != 0) continue;
+		num = next_candidate(mask, d->words, 0);
+		if(num == 0){ /* no possible value */
+			d->contradiction = true;
+			return changed;
+		}
+		if(next_candidate(mask, d->words, num) == 0){
+			deduce_position(d, x, y, num);
+			changed = true;
+		}
+	}
+	
+	return changed;
+}
+
+/*
+goes over positions of "num" in every unit:
+a single position is filled (hidden single),
+if "reductions" is true, also:
+positions of a block in a single row or column remove "num" from rest of row or column (pointing),
+positions of a row or column in a single block remove "num" from rest of block (box/line reduction)
+
+returns whether any change was made
+*/
+bool deduce_units(Deduction* d, bool reductions){
+	Board* board = d->board;
+	int N = board->cell_w * board->cell_h;
+	int kind, unit, num, i, x, y;
+	bool changed = false;
+	
+	for(kind = 0; kind < UNIT_KINDS; kind++) for(unit = 0; unit < N; unit++) for(num = 1; num <= N; num++){
+		int count = 0, first_x = 0, first_y = 0;
+		bool placed = false, same_row = true, same_col = true, same_block = true;
+		
+		/* find positions of number in unit */
+		for(i = 0; i < N && ! placed; i++){
+			unit_position(board, kind, unit, i, &x, &y);
+			if(board->table[y][x] == num) placed = true;
+			else if(in_mask(deduction_mask(d, x, y), num)){
+				if(count == 0){
+					first_x = x;
+					first_y = y;
+				}
+				same_row = same_row && y == first_y;
+				same_col = same_col && x == first_x;
+				same_block = same_block && get_block_index(board, x, y) == get_block_index(board, first_x, first_y);
+				count++;
+			}
+		}
+		if(placed) continue;
+		
+		if(count == 0){ /* number can't be placed in unit */
+			d->contradiction = true;
+			return changed;
+		}
+		if(count == 1){
+			deduce_position(d, first_x, first_y, num);
+			changed = true;
+			continue;
+		}
+		if(! reductions) continue;
+		
+		if(kind == UNIT_BLOCK && (same_row || same_col)){
+			/* remove from rest of row or column */
+			for(i = 0; i < N; i++){
+				x = same_row ? i : first_x;
+				y = same_row ? first_y : i;
+				if(get_block_index(board, x, y) != unit && eliminate(d, x, y, num)) changed = true;
+			}
+		}
+		if(kind != UNIT_BLOCK && same_block){
+			/* remove from rest of block */
+			int block = get_block_index(board, first_x, first_y);
+			for(i = 0; i < N; i++){
+				unit_position(board, UNIT_BLOCK, block, i, &x, &y);
+				if((kind == UNIT_ROW ? y != unit : x != unit) && eliminate(d, x, y, num)) changed = true;
+			}
+		}
+	}
+	
+	return changed;
+}
+
+/*
+starts deduction on a copy of given non erronous board
+returns true on error
+*/
+bool start_deduction(Deduction* d, Board* board){
+	Candidates* cands;
+	int N = board->cell_w * board->cell_h;
+	int x, y;
+	
+	d->board = copy_board(board);
+	if(d->board == NULL) return true;
+	
+	cands = create_candidates(board);
+	if(cands == NULL){
+		free_board(d->board);
+		return true;
+	}
+	d->words = cands->words;
+	d->contradiction = false;
+	
+	d->masks = calloc(N*N * d->words, sizeof(MaskWord));
+	if(d->masks == NULL){
+		fprintf(stderr,"Error: calloc has failed\n");
+		free_candidates(cands);
+		free_board(d->board);
+		return true;
+	}
+	
+	for(y = 0; y < N; y++) for(x = 0; x < N; x++){
+		if(board->table[y][x] == 0) get_candidates(cands, x, y, deduction_mask(d, x, y));
+	}
+	free_candidates(cands);
+	return false;
+}
+
+/*
+frees memory of deduction
+*/
+void end_deduction(Deduction* d){
+	free(d->masks);
+	free_board(d->board);
+}
+
+/*
+runs deductions until position x,y is known (or whole board if x is negative),
+a contradiction is found or nothing changes
+*/
+void run_deduction(Deduction* d, int x, int y, bool reductions){
+	int N = d->board->cell_w * d->board->cell_h;
+	bool changed = true;
+	
+	while(changed && ! d->contradiction && (x < 0 ? d->board->filled < N*N : d->board->table[y][x] == 0)){
+		changed = deduce_naked_singles(d);
+		if(! d->contradiction) changed = deduce_units(d, reductions) || changed;
+	}
+}
+
+/*
+tries to deduce value of empty position x,y of a non erronous board using logic techniques
+(singles, pointing and box/line reduction, repeated while they make progress)
+deductions only rule out values, so they might fill a position of a board that has no solution,
+therefore value is deduced only if whole board is filled, which shows board has that single solution
+
+outputs value to "value", 0 if it could not be deduced, -1 if board was shown to have no solution
+returns true on error
+*/
+bool deduce_value(Board* board, int x, int y, int* value){
+	Deduction d;
+	int N = board->cell_w * board->cell_h;
+	
+	if(start_deduction(&d, board)) return true;
+	
+	run_deduction(&d, -1, -1, true);
+	
+	if(d.contradiction) *value = -1;
+	else if(d.board->filled == N*N) *value = d.board->table[y][x];
+	else *value = 0; /* board might have no solution */
+	
+	end_deduction(&d);
+	return false;
+}
+
+/*
+checks whether non erronous board can be completely solved using logic techniques
+(singles, and pointing and box/line reduction if "reductions" is true)
+outputs result to "solvable"
+returns true on error
+*/
+bool logic_solvable(Board* board, bool reductions, bool* solvable){
+	Deduction d;
+	int N = board->cell_w * board->cell_h;
+	
+	if(start_deduction(&d, board)) return true;
+	
+	run_deduction(&d, -1, -1, reductions);
+	*solvable = ! d.contradiction && d.board->filled == N*N;
+	
+	end_deduction(&d);
+	return false;
+}
+
+/*
+returns whether given solution is a solution of board (has all its values)
+*/
+bool is_solution_of(Board* solution, Board* board){
+	int N = board->cell_w * board->cell_h;
+	int x, y;
+	for(y = 0; y < N; y++) for(x = 0; x < N; x++){
+		if(board->table[y][x] != 0 && board->table[y][x] != solution->table[y][x]) return false;
+	}
+	return true;
+}
+
 bool hint(Game* g, int x, int y){
-	Board* board = g->current_state->board; /* get currnet board */
+	Board* board = g->board; /* get currnet board */
 	Board* sol; /* solution */
+	int value; /* deduced value */
 	
 	/* check for immediate errors */
 	if(check_board(board)){
@@ -60,7 +432,36 @@ bool hint(Game* g, int x, int y){
 		fprintf(stderr, "Error: cell already contains a value\n");
 		return false;
 	}
-	sol = solve(board);
+	
+	/* state already solved */
+	if(g->current_state->solution != NULL){
+		printf("Hint: set cell to %d\n", g->current_state->solution->table[y][x]);
+		return false;
+	}
+	if(g->current_state->unsolvable){
+		fprintf(stderr, "Error: board is unsolvable\n");
+		return false;
+	}
+	
+	/* last solution is still a solution if only its values were added since */
+	if(g->solution != NULL && is_solution_of(g->solution, board)){
+		printf("Hint: set cell to %d\n", g->solution->table[y][x]);
+		return false;
+	}
+	
+	if(deduce_value(board, x, y, &value)) return true;
+	if(value > 0){
+		printf("Hint: set cell to %d\n", value); /* print hint */
+		return false;
+	}
+	if(value < 0){ /* deductions showed board has no solution */
+		g->current_state->unsolvable = true;
+		fprintf(stderr, "Error: board is unsolvable\n");
+		return false;
+	}
+	
+	/* logic is not enough, solve board */
+	sol = solve_current(g); /* kept by game for next hints */
 	if(sol == NULL){
 		return true; /* some error in solution */
 	}
@@ -70,8 +471,6 @@ bool hint(Game* g, int x, int y){
 	}
 	
 	printf("Hint: set cell to %d\n", sol->table[y][x]); /* print hint */
-	
-	free_board(sol);
 	return false;
 }
 
@@ -80,12 +479,12 @@ given an array "arr", of length "len"
 
 randomly choose "num" values in a certain oreder, and move them to begining of "arr"
 */
-void random_choose(int* arr, int len, int num){
+void random_choose(int* arr, int len, int num, Random* rng){
 	int i;
 	for(i = 0; i<num; i++){
 		int temp, ind;
 		/* choose position which was not chosen yet */
-		ind = i + rand() % (len-i); /* random number in range i,...,len-1 */
+		ind = i + random_below(rng, len-i); /* random number in range i,...,len-1 */
 		/* swap with i'th position */
 		temp = arr[ind];
 		arr[ind] = arr[i];
@@ -98,7 +497,155 @@ number of attempts to generate board
 */
 #define MAX_GEN_ATTEMPTS 1000
 
-Board* generate(Board* b, int add, int remaining){
+/*
+checks whether values of "num" positions (in board memory) removed from a board with a single solution
+can be deduced with logic techniques, in which case board still has a single solution
+outputs result to "forced"
+returns true on error
+*/
+bool removal_forced(Board* board, int* pos, int* values, int num, bool* forced){
+	Deduction d;
+	int N = board->cell_w * board->cell_h;
+	int i;
+	
+	if(start_deduction(&d, board)) return true;
+	
+	*forced = true;
+	for(i = 0; i < num && *forced; i++){
+		run_deduction(&d, pos[i] % N, pos[i] / N, true);
+		*forced = ! d.contradiction && d.board->memory[pos[i]] == values[i];
+	}
+	
+	end_deduction(&d);
+	return false;
+}
+
+/*
+checks whether board, which has a solution with "values" at "num" positions (in board memory),
+might have another solution (differing in one of the positions)
+searches are limited by node limit of solver, so "other" is also set if search was stopped
+"legal" has room for N values
+outputs result to "other"
+returns true on error
+*/
+bool other_solution(SolverContext* solver, Board* board, int* pos, int* values, int num, int* legal, bool* other){
+	int N = board->cell_w * board->cell_h;
+	int i, j, legal_num;
+	Board* sol;
+	Deduction d;
+	
+	*other = false;
+	
+	/* solutions where first i positions have their values, and i'th has a different one */
+	for(i = 0; i < num && ! *other; i++){
+		legal_num = count_legal_values(board, pos[i] % N, pos[i] / N, legal);
+		for(j = 0; j < legal_num && ! *other; j++){
+			if(legal[j] == values[i]) continue;
+			
+			set_cell(board, pos[i] % N, pos[i] / N, legal[j]);
+			
+			/* most values are ruled out by logic, board is solved only if logic is not enough */
+			if(start_deduction(&d, board)) return true;
+			run_deduction(&d, -1, -1, true);
+			if(d.contradiction) sol = board;
+			else if(d.board->filled == N*N) sol = copy_board(d.board);
+			else sol = solve_with(solver, board);
+			end_deduction(&d);
+			
+			set_cell(board, pos[i] % N, pos[i] / N, 0);
+			
+			if(sol == NULL) return true; /* error */
+			if(sol != board){
+				free_board(sol);
+				*other = true;
+			}
+			else if(solver->stopped) *other = true; /* not known */
+		}
+		set_cell(board, pos[i] % N, pos[i] / N, values[i]);
+	}
+	
+	/* positions are still removed */
+	for(i = 0; i < num; i++) set_cell(board, pos[i] % N, pos[i] / N, 0);
+	return false;
+}
+
+/*
+search nodes allowed when checking a removal for other solutions
+*/
+#define DIG_NODE_LIMIT 2000
+
+/*
+removes values of "sol" (a solved board) one position at a time in order of "positions" (N*N positions),
+keeping removals only while board has a single solution (and meets options),
+until "remaining" values remain
+
+a removal keeps a single solution if its values are deduced with logic techniques,
+or if board has no solution with other values in removed positions
+(searches for other solutions are limited, removals needing longer searches are not kept)
+
+returns true on error
+*/
+bool dig_out(Game* g, Board* sol, int* positions, int remaining, GenOptions* options){
+	int N = sol->cell_w * sol->cell_h;
+	int* legal; /* legal values of a position */
+	SolverContext* solver = get_solver(g);
+	int i, j;
+	
+	if(solver == NULL) return true;
+	
+	legal = calloc(N, sizeof(int));
+	if(legal == NULL){
+		fprintf(stderr,"Error: calloc has failed\n");
+		return true;
+	}
+	solver->node_limit = DIG_NODE_LIMIT;
+	
+	for(i = 0; i < N*N && sol->filled > remaining; i++){
+		int pair[2], values[2]; /* position (with symmetric one) and their values */
+		int num = 1; /* number of positions removed together */
+		bool keep; /* whether removal is kept */
+		bool error;
+		
+		pair[0] = positions[i];
+		if(options->symmetric && N*N-1 - pair[0] != pair[0]) pair[num++] = N*N-1 - pair[0]; /* symmetric around center */
+		
+		if(sol->memory[pair[0]] == 0) continue; /* already removed with its symmetric position */
+		if(sol->filled - num < remaining) continue; /* would remove too much */
+		
+		for(j = 0; j < num; j++){
+			values[j] = sol->memory[pair[j]];
+			set_cell(sol, pair[j] % N, pair[j] / N, 0);
+		}
+		
+		if(options->difficulty != DIFFICULTY_HARD){
+			/* puzzle solved by logic has a single solution */
+			error = logic_solvable(sol, options->difficulty == DIFFICULTY_MEDIUM, &keep);
+		}
+		else{
+			error = removal_forced(sol, pair, values, num, &keep);
+			if(! error && ! keep){
+				error = other_solution(solver, sol, pair, values, num, legal, &keep);
+				keep = ! keep;
+			}
+		}
+		if(error){
+			solver->node_limit = 0;
+			free(legal);
+			return true;
+		}
+		
+		if(! keep){
+			for(j = 0; j < num; j++) set_cell(sol, pair[j] % N, pair[j] / N, values[j]); /* restore */
+		}
+	}
+	
+	solver->node_limit = 0;
+	free(legal);
+	return false;
+}
+
+Board* generate(Game* g, int add, int remaining, GenOptions* options, Random* rng){
+	Board* b = g->board; /* current board */
 	Board* new_board, *sol;
 	int* positions; /* array of positions in board memory */
 	int N = b->cell_w*b->cell_h;
@@ -133,10 +680,10 @@ Board* generate(Board* b, int add, int remaining){
 	
 	for(attempt = 0; attempt < MAX_GEN_ATTEMPTS; attempt++){
 		
-		for(i=0; i<N*N;i++) new_board->memory[i] = 0; /* clear board */
+		for(i=0; i<N*N;i++) set_cell(new_board, i % N, i / N, 0); /* clear board */
 		
 		/* choose positions to set */
-		random_choose(positions, N*N, add);
+		random_choose(positions, N*N, add, rng);
 		
 		/* set chosen positions */
 		for(i=0; i<add;i++){
@@ -152,12 +699,12 @@ Board* generate(Board* b, int add, int remaining){
 			}
 			
 			/* set position to legal value */
-			new_board->memory[positions[i]] = values[rand() % num_legal];
+			set_cell(new_board, x, y, values[random_below(rng, num_legal)]);
 			
 		}
-		if(i<add) break; /* attempt failed: a position had no legal value */
+		if(i<add) continue; /* attempt failed: a position had no legal value */
 		
-		sol = solve(new_board);
+		sol = game_solve(g, new_board); /* same solver context for all attempts */
 		if(sol == NULL){ /* error */
 			free(values);
 			free(positions);
@@ -169,10 +716,21 @@ Board* generate(Board* b, int add, int remaining){
 			free(values);
 			free_board(new_board);
 			
-			/* choose remaining positions */
-			random_choose(positions, N*N, remaining);
-			/* go over all other positions and clear them */
-			for(i=remaining; i<N*N; i++) sol->memory[positions[i]] = 0;
+			if(options->unique){
+				/* try all positions in random order */
+				random_choose(positions, N*N, N*N, rng);
+				if(dig_out(g, sol, positions, remaining, options)){
+					free(positions);
+					free_board(sol);
+					return NULL;
+				}
+			}
+			else{
+				/* choose remaining positions */
+				random_choose(positions, N*N, remaining, rng);
+				/* go over all other positions and clear them */
+				for(i=remaining; i<N*N; i++) set_cell(sol, positions[i] % N, positions[i] / N, 0);
+			}
 			
 			free(positions);
 			return sol;
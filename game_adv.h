@@ -8,20 +8,47 @@ autofill, hint finding etc
 */
 
 #include "solver.h"
+#include "prng.h"
 
 
+/*
+difficulty of generated puzzles, by logic techniques needed to solve them
+*/
+typedef enum difficulty_enum{
+	DIFFICULTY_EASY, /* singles only */
+	DIFFICULTY_MEDIUM, /* singles, pointing and box/line reduction */
+	DIFFICULTY_HARD /* any puzzle */
+} Difficulty;
+
+/*
+options of puzzle generation
+*/
+typedef struct gen_options_struct{
+	bool unique; /* only remove values while solution stays unique */
+	bool symmetric; /* remove values in pairs symmetric around center (only with unique) */
+	Difficulty difficulty; /* hardest puzzle allowed (only with unique) */
+} GenOptions;
+
 /*
 generates board by adding "add" random leagal values, solving, then removing cells until "remaining" cells remain
 
+if options->unique is set, values are removed one at a time (or symmetric pair) in random order,
+and a removal is kept only if puzzle still has a single solution and meets difficulty,
+so puzzle might have more than "remaining" values
+
+random choices are taken from "rng"
+
 on error, returns NULL
-on failure, returns "b"
+on failure, returns game board
 
-assumes board is empty
+assumes game board is empty
 */
-Board* generate(Board* b, int add, int remaining);
+Board* generate(Game* g, int add, int remaining, GenOptions* options, Random* rng);
 
 /*
 tries to print hint for given board on given position
+value is deduced with logic techniques when possible, otherwise board is solved
+(solutions are kept by game, and last solution is used while board only has values of it)
 
 if no hint can be made, prints message explaining why
 
@@ -31,10 +58,15 @@ bool hint(Game* g, int x, int y);
 
 /*
 given a non erronous board, returns a copy with obvious values added
+(positions with a single legal value on given board)
+
+in full mode, also fills numbers with a single legal position in a row, column or block,
+and repeats until no more values can be deduced (filled board is never erronous)
+
 on error (in allocation) returns NULL
 
 if no changes are made, returns board
 */
-Board* autofill(Board* b);
+Board* autofill(Board* b, bool full);
 
 #endif
\ No newline at end of file
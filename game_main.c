@@ -3,15 +3,22 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 void print_game(GameState* state){
 	print_board(state->game, state->mark_errors || state->mode == MODE_EDIT);
 }
 
+void refresh_game(GameState* state){
+	if(! state->quiet) print_game(state);
+}
+
 void set_init(GameState* state){
 	state->game = NULL;
 	state->mode = MODE_INIT;
 	state->mark_errors = true;
+	state->threads = 1;
+	state->quiet = false;
 }
 
 bool open_solve(GameState* state, char* filename){
@@ -21,7 +28,7 @@ bool open_solve(GameState* state, char* filename){
 	if(state->game) free_game(state->game); /* delete old game */
 	state->game = new_game;
 	state->mode = MODE_SOLVE;
-	print_game(state);
+	refresh_game(state);
 	return false;
 }
 
@@ -32,7 +39,7 @@ bool open_edit(GameState* state, char* filename){
 	if(state->game) free_game(state->game);
 	state->game = new_game;
 	state->mode = MODE_EDIT;
-	print_game(state);
+	refresh_game(state);
 	return false;
 }
 
@@ -45,7 +52,7 @@ bool open_default(GameState* state){
 	if(state->game) free_game(state->game);
 	state->game = new_game;
 	state->mode = MODE_EDIT;
-	print_game(state);
+	refresh_game(state);
 	return false;
 }
 
@@ -55,19 +62,12 @@ bool try_set(GameState* state, int x, int y, int z){
 		printf("Error: cell is fixed\n");
 	}
 	else{
-		/* clear undo list beyond current position */
-		if(state->game->current_state->next) free_board_list(state->game->current_state->next);
-		state->game->undo_list_tail = state->game->current_state;
-		
-		if(! add_state(state->game)){
+		/* set position as new move */
+		if(! set_move(state->game, x, y, z)){
 			return true; /* error */
 		}
-		state->game->current_state = state->game->current_state->next; /* advance one state */
 		
-		/* set position */
-		state->game->current_state->board->table[y][x] = z;
-				
-		print_game(state);
+		refresh_game(state);
 		check_win(state);
 	}
 	
@@ -75,13 +75,9 @@ bool try_set(GameState* state, int x, int y, int z){
 }
 
 bool try_undo(GameState* state){
-	if(state->game->current_state->prev){ /* if previous state exists can undo */
-		state->game->current_state = state->game->current_state->prev; /* move back */
-		print_game(state); /* print board */
-		print_changes(
-				state->game->current_state->next->board,
-				state->game->current_state->board,
-				CHANGE_UNDO); /* print changes */
+	if(undo_move(state->game)){ /* if previous state exists can undo */
+		refresh_game(state); /* print board */
+		print_changes(state->game->current_state->next, CHANGE_UNDO); /* print changes of undone move */
 	}
 	else{
 		fprintf(stderr, "Error: no moves to undo\n");
@@ -89,13 +85,9 @@ bool try_undo(GameState* state){
 	return false;
 }
 bool try_redo(GameState* state){
-	if(state->game->current_state->next){ /* if next state exists can redo */
-		state->game->current_state = state->game->current_state->next; /* move back */
-		print_game(state); /* print board */
-		print_changes(
-				state->game->current_state->prev->board,
-				state->game->current_state->board,
-				CHANGE_REDO); /* print changes */
+	if(redo_move(state->game)){ /* if next state exists can redo */
+		refresh_game(state); /* print board */
+		print_changes(state->game->current_state, CHANGE_REDO); /* print changes of redone move */
 	}
 	else{
 		fprintf(stderr, "Error: no moves to redo\n");
@@ -104,27 +96,24 @@ bool try_redo(GameState* state){
 }
 
 void reset(GameState* state){
-	state->game->current_state = state->game->undo_list_tail = state->game->undo_list_head; /* shrink undo list to first state */
-	
-	if(state->game->current_state->next) free_board_list(state->game->current_state->next); /* clear rest of list */
+	reset_game(state->game); /* go back to first state and clear rest of list */
 	
 	printf("Board reset\n");
-	print_game(state);
+	refresh_game(state);
 }
 
 bool validate(GameState* state){
 	Board* solution;
-	if(check_board(state->game->current_state->board)){
+	if(check_board(state->game->board)){
 		fprintf(stderr, "Error: board contains erroneous values\n");
 		return false;
 	}
-	solution = solve(state->game->current_state->board);
+	solution = solve_current(state->game); /* kept by game */
 	if(solution == NULL) return true;
-	if(solution == state->game->current_state->board){
+	if(solution == state->game->board){
 		printf("Validation failed: board is unsolvable\n");
 	}
 	else{
-		free_board(solution);
 		printf("Validation passed: board is solvable\n");
 	}
 	return false;
@@ -133,18 +122,16 @@ bool validate(GameState* state){
 bool save_game(GameState* state, char* filename){
 	Board* solution;
 	if(state->mode == MODE_EDIT){
-		if(check_board(state->game->current_state->board)){
+		if(check_board(state->game->board)){
 			fprintf(stderr,"Error: board contains erroneous values\n");
 			return false;
 		}
-		solution = solve(state->game->current_state->board);
+		solution = solve_current(state->game); /* kept by game */
 		if(solution == NULL) return true;
-		if(solution == state->game->current_state->board){
-			/* solution board is not a new board, and shouldn't be free'd */
+		if(solution == state->game->board){
 			fprintf(stderr, "Error: board validation failed\n");
 			return false;
 		}
-		free_board(solution); /* free solution board */
 	}
 	if(save_board(state->game, filename, state->mode == MODE_EDIT)){
 		printf("Saved to: %s\n", filename);
@@ -155,92 +142,117 @@ bool save_game(GameState* state, char* filename){
 	return false;
 }
 
-bool print_solution_num(GameState* state){
-	int sol_num; /* number of solutions */
-	if(check_board(state->game->current_state->board)){
+bool print_solution_num(GameState* state, int limit){
+	WideCount sol_num; /* number of solutions */
+	char sol_str[COUNT_STRING_LENGTH]; /* sol_num as text */
+	bool interrupted;
+	if(check_board(state->game->board)){
 		fprintf(stderr, "Error: board contains erroneous values\n");
 		return false;
 	}
-	if(! count_solutions(state->game->current_state->board, &sol_num)){
+	if(! count_solutions(state->game->board, state->threads, limit, stdout, &sol_num, &interrupted)){
 		return true; /* error */
 	}
-	printf("Number of solutions: %d\n", sol_num);
-	if(sol_num == 1){
+	count_to_string(&sol_num, sol_str);
+	if(interrupted){
+		printf("Counting interrupted\n");
+		printf("Number of solutions: at least %s\n", sol_str); /* partial count is a lower bound */
+	}
+	else if(limit > 0 && compare_count(&sol_num, limit) == 0){
+		printf("Number of solutions: at least %s\n", sol_str); /* search was stopped */
+	}
+	else{
+		printf("Number of solutions: %s\n", sol_str);
+	}
+	if(compare_count(&sol_num, 1) == 0 && !interrupted){
 		printf("This is a good board!\n");
 	}
-	else if(sol_num > 1){
+	else if(compare_count(&sol_num, 1) > 0){
 		printf("The puzzle has more than 1 solution, try editing it further\n");
 	}
 	return false;
 }
 
-bool try_generate(GameState* state, int add, int remain){
+bool get_gen_options(char** params, int param_num, GenOptions* options){
+	int i;
+	
+	/* defaults, random removal */
+	options->unique = options->symmetric = false;
+	options->difficulty = DIFFICULTY_HARD;
+	
+	for(i = 0; i < param_num; i++){
+		if(strcmp(params[i], "unique") == 0) options->unique = true;
+		else if(strcmp(params[i], "symmetric") == 0) options->unique = options->symmetric = true;
+		else if(strcmp(params[i], "easy") == 0){
+			options->unique = true;
+			options->difficulty = DIFFICULTY_EASY;
+		}
+		else if(strcmp(params[i], "medium") == 0){
+			options->unique = true;
+			options->difficulty = DIFFICULTY_MEDIUM;
+		}
+		else{
+			fprintf(stderr, "Error: generate options should be unique, symmetric, easy or medium\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool try_generate(GameState* state, int add, int remain, GenOptions* options){
 	int N = get_game_size(state->game);
 	Board* new;
-	if(count_empty_places(state->game->current_state->board, NULL, NULL) != N*N){ /* board not empty */
+	if(count_empty_places(state->game->board, NULL, NULL) != N*N){ /* board not empty */
 		fprintf(stderr, "Error: board is not empty\n");
 		return false;
 	}
 	/* generate board */
-	new = generate(state->game->current_state->board, add, remain);
+	new = generate(state->game, add, remain, options, &state->rng);
 	if(new == NULL) return true; /* error */
-	if(new == state->game->current_state->board){
+	if(new == state->game->board){
 		fprintf(stderr, "Error: puzzle generator failed\n");
 		return false;
 	}
-	/* clear undo list beyond current position */
-	if(state->game->current_state->next) free_board_list(state->game->current_state->next);
-	state->game->undo_list_tail = state->game->current_state;
-	
-	if(! add_state(state->game)){
+	/* all generated positions are a single move */
+	if(! board_move(state->game, new)){
 		free_board(new);
 		return true; /* error */
 	}
-	state->game->current_state = state->game->current_state->next; /* advance one state */
+	free_board(new);
 	
-	
-	replace_node_board(state->game->current_state,new);
-	print_game(state);
+	refresh_game(state);
 	return false;
 }
 
-bool try_autofill(GameState* state){
+bool try_autofill(GameState* state, bool full){
 	Board* new;
 	
-	if(check_board(state->game->current_state->board)){
+	if(check_board(state->game->board)){
 		fprintf(stderr, "Error: board contains erroneous values\n");
 		return false;
 	}
 	
-	new = autofill(state->game->current_state->board);
+	new = autofill(state->game->board, full);
 	if(new == NULL) return true; /* error */
-	if(new == state->game->current_state->board) return false; /* no changes */
+	if(new == state->game->board) return false; /* no changes */
 
-	/* clear undo list beyond current position */
-	if(state->game->current_state->next) free_board_list(state->game->current_state->next);
-	state->game->undo_list_tail = state->game->current_state;
-	
-	if(! add_state(state->game)){
+	/* all filled positions are a single move */
+	if(! board_move(state->game, new)){
 		free_board(new);
 		return true; /* error */
 	}
-	state->game->current_state = state->game->current_state->next; /* advance one state */
+	free_board(new);
 	
-	replace_node_board(state->game->current_state,new);
-	/* print changes */
-	print_changes(
-			state->game->current_state->prev->board,
-			state->game->current_state->board,
-			CHANGE_SET);
-	print_game(state);
+	print_changes(state->game->current_state, CHANGE_SET); /* print changes */
+	refresh_game(state);
 	check_win(state); /* check for end condition */
 	return false;
 }
 
 void check_win(GameState* state){
-	if(state->mode == MODE_SOLVE && count_empty_places(state->game->current_state->board, NULL, NULL) == 0){
+	if(state->mode == MODE_SOLVE && count_empty_places(state->game->board, NULL, NULL) == 0){
 		/* full board */
-		if(check_board(state->game->current_state->board)){
+		if(check_board(state->game->board)){
 			printf("Puzzle solution erroneous\n");
 		}
 		else{
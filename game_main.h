@@ -17,6 +17,9 @@ typedef struct game_state_struct{
 	GameMode mode;
 	Game* game;
 	bool mark_errors;
+	int threads; /* number of threads for counting solutions */
+	bool quiet; /* whether board is printed only by print command */
+	Random rng; /* random generator of generate command */
 } GameState;
 
 
@@ -53,6 +56,11 @@ print board of given game state
 */
 void print_game(GameState* state);
 
+/*
+print board of given game state after it changed, unless state is quiet
+*/
+void refresh_game(GameState* state);
+
 /*
 validate current state of game state and print results
 
@@ -67,12 +75,19 @@ if it is go to init mode
 */
 void check_win(GameState* state);
 
+/*
+default limit for number of solutions, enough to tell if the puzzle has a unique solution
+*/
+#define DEFAULT_SOLUTION_LIMIT 2
+
 /*
 prints number of solutions or error message if error occures
 
+counting stops after "limit" solutions are found (0 for no limit)
+
 returns true on fatal error
 */
-bool print_solution_num(GameState* state);
+bool print_solution_num(GameState* state, int limit);
 
 /*
 tries to set position on given game
@@ -109,21 +124,33 @@ returns true on fatal error
 */
 bool save_game(GameState* state, char* filename);
 
+/*
+reads generate options from "params" (words unique, symmetric, easy and medium, see GenOptions)
+returns whether successful, if not print error message
+*/
+bool get_gen_options(char** params, int param_num, GenOptions* options);
+
 /*
 if board is empty generate puzzle
 print all errors
 
-adds "add" random values, solves, removes all but "remain" values
+adds "add" random values, solves, removes all but "remain" values (see generate)
 
 on fatal error return true
 */
-bool try_generate(GameState* state, int add, int remain);
+bool try_generate(GameState* state, int add, int remain, GenOptions* options);
+
+/*
+parameter of autofill for full mode
+*/
+#define AUTOFILL_FULL "full"
 
 /*
-tries to autofill board
+tries to autofill board, in full mode deductions are repeated until none are left (see autofill)
+all filled positions are a single move
 
 on fatal error return true
 */
-bool try_autofill(GameState* state);
+bool try_autofill(GameState* state, bool full);
 
 #endif
\ No newline at end of file
@@ -1,16 +1,22 @@
 #include "game_main.h"
+#include "batch.h"
+#include "stats.h"
 
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 
-int main(){
+int main(int argc, char** argv){
 	GameState state;
+	Options options; /* command line options */
 	
 	char* params[MAX_PARAM_NUM]; /* parameters for command */
 	int x,y,z; /* integer parameters */
 	int param_num; /* number of parameters */ 
+	GenOptions gen_options; /* options of generate command */
+	FILE* input = stdin; /* source of commands */
 	
 	/* controls */
 	bool error = false;
@@ -19,6 +25,29 @@ int main(){
 	
 	int i;
 	
+	if(! get_options(argc, argv, &options)) return 1;
+	if(! options.seeded) options.seed = time(NULL);
+	
+	if(options.generate > 0){
+		/* batch generation, without interactive game */
+		if(! get_gen_options(options.gen_words, options.gen_word_num, &gen_options)) return 1;
+		if(options.gen_word_num == 0) gen_options.unique = true; /* puzzles are unique by default */
+		if(! options.seeded) fprintf(stderr, "Seed: %lu\n", options.seed); /* for reproducing output */
+		return batch_generate(&options, &gen_options) ? 0 : 1;
+	}
+	if(options.solve != NULL){
+		/* batch solving, without interactive game */
+		return batch_solve(&options) ? 0 : 1;
+	}
+	
+	if(options.commands != NULL){
+		input = fopen(options.commands, "r");
+		if(input == NULL){
+			fprintf(stderr, "Error: File %s doesn't exist or cannot be opened\n", options.commands);
+			return 1;
+		}
+	}
+	
 	for(i=0; i<MAX_PARAM_NUM; i++){
 		params[i] = calloc(MAX_COMMAND_LENGTH, sizeof(char));
 		if(params[i] == NULL){
@@ -28,13 +57,16 @@ int main(){
 	}
 	
 	set_init(&state);
+	state.threads = options.threads;
+	state.quiet = options.script; /* scripts print board only when asked to */
+	seed_random(&state.rng, options.seed, 0);
 	
 	printf("Sudoku\n------\n"); /* title */
 	
 	while(!(error || finished)){
 		int N = state.game ? get_game_size(state.game) : 0; /* get game size */
-		int E = state.game ? count_empty_places(state.game->current_state->board, NULL, NULL) : 0; /* number of empty cells, locations are not saved */
-		switch(get_command(state.mode, params, &param_num)){
+		int E = state.game ? count_empty_places(state.game->board, NULL, NULL) : 0; /* number of empty cells, locations are not saved */
+		switch(get_command(input, ! options.script, state.mode, params, &param_num)){
 		case CMD_SOLVE:
 			if(open_solve(&state, params[0])) error = true;
 			break;
@@ -54,11 +86,17 @@ int main(){
 			}
 			break;
 		case CMD_AUTOFILL:
-			if(try_autofill(&state)) error = true;
+			/* optional mode, "full" repeats deductions until none are left */
+			if(param_num == 1 && strcmp(params[0], AUTOFILL_FULL) != 0){
+				fprintf(stderr, "Error: autofill mode should be %s\n", AUTOFILL_FULL);
+				break;
+			}
+			if(try_autofill(&state, param_num == 1)) error = true;
 			break;
 		case CMD_GENERATE:
-			if(get_num_lim(params[0], &x, 0, E, 0) && get_num_lim(params[1], &y, 0, E, 0)){
-				try_generate(&state, x, y);
+			if(get_num_lim(params[0], &x, 0, E, 0) && get_num_lim(params[1], &y, 0, E, 0) &&
+					get_gen_options(params + 2, param_num - 2, &gen_options)){
+				if(try_generate(&state, x, y, &gen_options)) error = true;
 			}
 			break;
 		case CMD_PRINT:
@@ -82,11 +120,25 @@ int main(){
 			if(save_game(&state, params[0])) error = true;
 			break;
 		case CMD_COUNT_SOLUTIONS:
-			if(print_solution_num(&state)) error = true;
+			/* optional limit on number of solutions, 0 counts all */
+			if(param_num == 0) x = DEFAULT_SOLUTION_LIMIT;
+			else if(! get_int_param(params[0], &x) || x < 0){
+				fprintf(stderr, "Error: limit should be a non-negative integer\n");
+				break;
+			}
+			if(print_solution_num(&state, x)) error = true;
 			break;
 		case CMD_RESET:
 			reset(&state);
 			break;
+		case CMD_STATS:
+			/* optional "reset" clears statistics instead of printing them */
+			if(param_num == 1){
+				if(strcmp(params[0], STATS_RESET) == 0) reset_stats();
+				else fprintf(stderr, "Error: stats parameter should be %s\n", STATS_RESET);
+			}
+			else print_stats();
+			break;
 		default: /* should never be reached */
 			error = true;
 			break;
@@ -94,6 +146,7 @@ int main(){
 	}
 	
 	if(state.game) free_game(state.game); /* free game if necessary */
+	if(input != stdin) fclose(input);
 	/* free parameter memory */
 	for(i=0; i<MAX_PARAM_NUM; i++){
 		if(params[i] != NULL) free(params[i]); /* free only if allocation is successful */
@@ -0,0 +1,264 @@
+#include "packed.h"
+
+#include <stdlib.h> /* allocation functions */
+#include <stdio.h>
+#include <string.h>
+#include <limits.h> /* LONG_MAX */
+
+/*
+initial number of offsets of a writer, doubled when full
+*/
+#define INITIAL_PACKED_CAPACITY 64
+
+/*
+writes "bytes" bytes of number to "pos", little endian
+*/
+void put_number(unsigned char* pos, unsigned long num, int bytes){
+	int i;
+	for(i = 0; i < bytes; i++){
+		pos[i] = num & 0xFF;
+		num >>= 8;
+	}
+}
+
+/*
+reads "bytes" bytes of little endian number from "pos"
+returns -1 if number does not fit a long
+*/
+long get_number(const unsigned char* pos, int bytes){
+	unsigned long num = 0;
+	int i;
+	for(i = bytes - 1; i >= 0; i--){
+		if(num > (unsigned long)LONG_MAX >> 8) return -1; /* too large */
+		num = (num << 8) | pos[i];
+	}
+	return num > (unsigned long)LONG_MAX ? -1 : (long)num;
+}
+
+/*
+returns number of bits a value of board of size N is packed in
+*/
+int value_bits(int N){
+	int bits = 1;
+	while((1 << bits) <= N) bits++;
+	return bits;
+}
+
+bool has_packed_extension(char* filename){
+	size_t len = strlen(filename), ext_len = strlen(PACKED_EXTENSION);
+	return len > ext_len && strcmp(filename + len - ext_len, PACKED_EXTENSION) == 0;
+}
+
+bool is_packed(const unsigned char* data, long length){
+	return length >= PACKED_HEADER_SIZE && memcmp(data, PACKED_MAGIC, strlen(PACKED_MAGIC)) == 0;
+}
+
+long packed_size(int cell_w, int cell_h){
+	long cells = (long)cell_w*cell_w*cell_h*cell_h;
+	/* dimensions, values and fixed bitmap */
+	return 2 + (cells * value_bits(cell_w*cell_h) + 7) / 8 + (cells + 7) / 8;
+}
+
+void pack_board(unsigned char* record, Board* board, bool** fixed){
+	int N = board->cell_w * board->cell_h;
+	int bits = value_bits(N);
+	unsigned char* values = record + 2;
+	unsigned char* fixed_map = values + ((long)N*N*bits + 7) / 8;
+	long bit = 0; /* position in values */
+	int x,y;
+
+	record[0] = board->cell_h;
+	record[1] = board->cell_w;
+	memset(values, 0, packed_size(board->cell_w, board->cell_h) - 2);
+
+	for(y = 0; y < N; y++){
+		for(x = 0; x < N; x++){
+			long pos = (long)y*N + x;
+			unsigned int value = board->table[y][x];
+			int done;
+
+			/* value might be split between bytes */
+			for(done = 0; done < bits; ){
+				int shift = (bit + done) % 8, take = 8 - shift;
+				if(take > bits - done) take = bits - done;
+				values[(bit + done) / 8] |= ((value >> done) & ((1u << take) - 1)) << shift;
+				done += take;
+			}
+			bit += bits;
+
+			/* without fixed, position is marked fixed if it is not empty */
+			if(fixed == NULL ? value != 0 : fixed[y][x]) fixed_map[pos / 8] |= 1 << (pos % 8);
+		}
+	}
+}
+
+bool record_dimensions(const unsigned char* record, long length, int* cell_w, int* cell_h){
+	if(length < 2 || record[0] == 0 || record[1] == 0){
+		fprintf(stderr, "Error: packed record has invalid dimensions\n");
+		return false;
+	}
+	*cell_h = record[0];
+	*cell_w = record[1];
+	if(*cell_w * *cell_h > MAX_BOARD_SIZE || packed_size(*cell_w, *cell_h) != length){
+		fprintf(stderr, "Error: packed record has invalid dimensions\n");
+		return false;
+	}
+	return true;
+}
+
+bool unpack_board(const unsigned char* record, Board* board, bool* fixed){
+	int N = board->cell_w * board->cell_h;
+	int bits = value_bits(N);
+	const unsigned char* values = record + 2;
+	const unsigned char* fixed_map = values + ((long)N*N*bits + 7) / 8;
+	long bit = 0, pos;
+
+	for(pos = 0; pos < (long)N*N; pos++){
+		unsigned int value = 0;
+		int done;
+
+		for(done = 0; done < bits; ){
+			int shift = (bit + done) % 8, take = 8 - shift;
+			if(take > bits - done) take = bits - done;
+			value |= ((values[(bit + done) / 8] >> shift) & ((1u << take) - 1)) << done;
+			done += take;
+		}
+		bit += bits;
+
+		if(value > (unsigned int)N){ /* does not fit board */
+			fprintf(stderr, "Error: packed record has invalid value\n");
+			return false;
+		}
+		set_cell(board, pos % N, pos / N, value);
+		if(fixed != NULL && (fixed_map[pos / 8] >> (pos % 8)) & 1) fixed[pos] = true; /* mark position as fixed */
+	}
+
+	return true;
+}
+
+bool open_packed_view(const unsigned char* data, long length, PackedView* view){
+	const unsigned char* trailer = data + length - PACKED_TRAILER_SIZE;
+	long index_offset, i, prev = PACKED_HEADER_SIZE;
+
+	if(! is_packed(data, length) || length < PACKED_HEADER_SIZE + PACKED_TRAILER_SIZE || data[4] != PACKED_VERSION){
+		fprintf(stderr, "Error: packed file has invalid header\n");
+		return false;
+	}
+
+	view->data = data;
+	view->length = length;
+	view->count = get_number(trailer, 8);
+	index_offset = get_number(trailer + 8, 8);
+
+	/* index fills space between records and trailer */
+	if(view->count < 0 || index_offset < PACKED_HEADER_SIZE ||
+			(length - PACKED_TRAILER_SIZE - index_offset) / 8 != view->count ||
+			(length - PACKED_TRAILER_SIZE - index_offset) % 8 != 0){
+		fprintf(stderr, "Error: packed file has invalid trailer\n");
+		return false;
+	}
+	view->index = data + index_offset;
+
+	/* records follow header in order, each at least 2 bytes, so checking order keeps all records inside file */
+	for(i = 0; i < view->count; i++){
+		long offset = get_number(view->index + 8*i, 8);
+		if(i == 0 ? offset != PACKED_HEADER_SIZE : offset < prev + 2){
+			fprintf(stderr, "Error: packed file has invalid index\n");
+			return false;
+		}
+		prev = offset;
+	}
+	if(view->count > 0 ? index_offset < prev + 2 : index_offset != PACKED_HEADER_SIZE){
+		fprintf(stderr, "Error: packed file has invalid index\n");
+		return false;
+	}
+
+	return true;
+}
+
+const unsigned char* packed_record(PackedView* view, long index, long* length){
+	long offset = get_number(view->index + 8*index, 8);
+	long end = index + 1 < view->count ? get_number(view->index + 8*(index + 1), 8) : view->index - view->data;
+	*length = end - offset;
+	return view->data + offset;
+}
+
+bool open_packed_writer(FILE* file, PackedWriter* writer){
+	unsigned char header[PACKED_HEADER_SIZE] = {0};
+
+	writer->file = file;
+	writer->count = 0;
+	writer->capacity = INITIAL_PACKED_CAPACITY;
+	writer->record = NULL;
+	writer->record_size = 0;
+	writer->offsets = calloc(writer->capacity, sizeof(long));
+	if(writer->offsets == NULL){
+		fprintf(stderr,"Error: calloc has failed\n");
+		return false;
+	}
+
+	memcpy(header, PACKED_MAGIC, strlen(PACKED_MAGIC));
+	header[4] = PACKED_VERSION;
+	if(fwrite(header, 1, PACKED_HEADER_SIZE, file) != PACKED_HEADER_SIZE){
+		fprintf(stderr, "Error: fwrite has failed\n");
+		free(writer->offsets);
+		return false;
+	}
+	writer->position = PACKED_HEADER_SIZE;
+	return true;
+}
+
+bool write_packed(PackedWriter* writer, Board* board, bool** fixed){
+	long size = packed_size(board->cell_w, board->cell_h);
+
+	if(writer->count == writer->capacity){
+		long* offsets = realloc(writer->offsets, 2 * writer->capacity * sizeof(long));
+		if(offsets == NULL){
+			fprintf(stderr, "Error: realloc has failed\n");
+			return false;
+		}
+		writer->offsets = offsets;
+		writer->capacity *= 2;
+	}
+	if(size > writer->record_size){
+		/* records usually have same size, so buffer is rarely replaced */
+		free(writer->record);
+		writer->record = malloc(size);
+		writer->record_size = writer->record ? size : 0;
+		if(writer->record == NULL){
+			fprintf(stderr,"Error: malloc has failed\n");
+			return false;
+		}
+	}
+
+	pack_board(writer->record, board, fixed);
+	if((long)fwrite(writer->record, 1, size, writer->file) != size){
+		fprintf(stderr, "Error: fwrite has failed\n");
+		return false;
+	}
+
+	writer->offsets[writer->count++] = writer->position;
+	writer->position += size;
+	return true;
+}
+
+bool close_packed_writer(PackedWriter* writer){
+	unsigned char entry[8];
+	unsigned char trailer[PACKED_TRAILER_SIZE];
+	bool success = true;
+	long i;
+
+	for(i = 0; i < writer->count && success; i++){
+		put_number(entry, writer->offsets[i], 8);
+		success = fwrite(entry, 1, 8, writer->file) == 8;
+	}
+
+	put_number(trailer, writer->count, 8);
+	put_number(trailer + 8, writer->position, 8); /* index starts after records */
+	if(success) success = fwrite(trailer, 1, PACKED_TRAILER_SIZE, writer->file) == PACKED_TRAILER_SIZE;
+	if(! success) fprintf(stderr, "Error: fwrite has failed\n");
+
+	free(writer->offsets);
+	free(writer->record);
+	return success;
+}
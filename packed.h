@@ -0,0 +1,118 @@
+#ifndef _PACKED_H
+#define _PACKED_H
+/*
+packed puzzle module
+binary format of boards for bulk storage, many boards are kept in a single container file
+
+container layout (numbers are little endian):
+	header: magic "SDKP", version byte, 3 zero bytes
+	records, one after another
+	index: offset of each record from start of file, 8 bytes each
+	trailer: number of records and offset of index, 8 bytes each
+
+record layout:
+	cell height and cell width, a byte each
+	N*N values row by row, each in ceil(log2(N+1)) bits, least significant bits first, padded to a byte
+	N*N bits of fixed positions row by row, padded to a byte
+*/
+
+#include "game.h"
+
+#define PACKED_MAGIC "SDKP"
+#define PACKED_VERSION 1
+#define PACKED_HEADER_SIZE 8
+#define PACKED_TRAILER_SIZE 16
+
+/*
+extension of file names saved in packed format
+*/
+#define PACKED_EXTENSION ".sdp"
+
+/*
+returns whether file name has packed format extension
+*/
+bool has_packed_extension(char* filename);
+
+/*
+returns whether data starts with header of a container
+*/
+bool is_packed(const unsigned char* data, long length);
+
+/*
+returns size of record of board with given dimensions
+*/
+long packed_size(int cell_w, int cell_h);
+
+/*
+writes board into "record" (packed_size bytes)
+positions marked in "fixed" are saved as fixed, if it is NULL all non-empty positions are fixed
+*/
+void pack_board(unsigned char* record, Board* board, bool** fixed);
+
+/*
+reads dimensions of record with given length
+returns whether successful, if not prints error
+*/
+bool record_dimensions(const unsigned char* record, long length, int* cell_w, int* cell_h);
+
+/*
+reads values of record into board of its dimensions
+positions marked fixed are set in "fixed" (N*N values, row by row), unless it is NULL
+returns whether successful, if not prints error
+*/
+bool unpack_board(const unsigned char* record, Board* board, bool* fixed);
+
+/*
+container read from memory, records are used in place
+*/
+typedef struct packed_view{
+	const unsigned char* data; /* whole container */
+	long length;
+	long count; /* number of records */
+	const unsigned char* index; /* offsets of records */
+} PackedView;
+
+/*
+opens view of container in memory, checking its header, trailer and index
+returns whether successful, if not prints error
+*/
+bool open_packed_view(const unsigned char* data, long length, PackedView* view);
+
+/*
+returns record with given index (0 to view->count-1) and outputs its length
+*/
+const unsigned char* packed_record(PackedView* view, long index, long* length);
+
+/*
+writer of container to open file, records are written as they are added
+*/
+typedef struct packed_writer{
+	FILE* file;
+	long position; /* bytes written so far */
+	long count; /* number of records */
+	long capacity; /* number of offsets allocated */
+	long* offsets; /* offset of each record */
+	unsigned char* record; /* buffer of last record */
+	long record_size; /* size of record buffer */
+} PackedWriter;
+
+/*
+starts container in open file (which may be a stream, no seeking is done)
+returns whether successful, if not prints error
+*/
+bool open_packed_writer(FILE* file, PackedWriter* writer);
+
+/*
+adds board as next record of container
+positions marked in "fixed" are saved as fixed, if it is NULL all non-empty positions are fixed
+returns whether successful, if not prints error
+*/
+bool write_packed(PackedWriter* writer, Board* board, bool** fixed);
+
+/*
+writes index and trailer of container, and frees writer (file is not closed)
+returns whether successful, if not prints error
+*/
+bool close_packed_writer(PackedWriter* writer);
+
+#endif
@@ -1,7 +1,9 @@
 #include "parser.h"
 
 #include <stdio.h>
-#include <stdlib.h> /* for atoi */
+#include <stdlib.h> /* for atoi, strtoul */
+#include <errno.h> /* range errors of strtoul */
+#include <limits.h> /* ULONG_MAX */
 #include <ctype.h> /* character handling */
 #include <string.h>
 
@@ -12,6 +14,7 @@ bool is_valid(CommandType comm, GameMode mode){
 	switch(comm){
 	case CMD_SOLVE:
 	case CMD_EDIT:
+	case CMD_STATS:
 	case CMD_EXIT:
 		return true; /* these commands are always valid */
 		
@@ -54,6 +57,16 @@ bool get_int_param(char* str, int* param){
 	*param = atoi(str); /* set output */
 	return true; /* success */
 }
+bool get_seed(char* str, unsigned long* seed){
+	char* pos; /* position in str */
+	
+	if(*str == '\0') return false;
+	for(pos = str; *pos; pos++) if(!isdigit(*pos)) return false; /* only digits */
+	
+	errno = 0;
+	*seed = strtoul(str, NULL, 10);
+	return errno != ERANGE; /* too large */
+}
 bool get_num_lim(char* str, int* out, int lower, int upper, int lower_print){
 	if(! get_int_param(str, out) || *out < lower || *out > upper){
 		fprintf(stderr, "Error: value not in range %d-%d\n", lower_print, upper);
@@ -71,8 +84,94 @@ bool get_bool(char* str, bool* out){
 	return true;
 }
 
+bool get_options(int argc, char** argv, Options* options){
+	int i;
+	
+	/* default values */
+	options->threads = 1;
+	options->generate = 0;
+	options->cell_w = options->cell_h = 3;
+	options->add = 9;
+	options->remain = 0;
+	options->gen_word_num = 0;
+	options->output = NULL;
+	options->solve = NULL;
+	options->count = false;
+	options->count_limit = 0;
+	options->script = false;
+	options->commands = NULL;
+	options->seeded = false;
+	options->seed = 0;
+	
+	for(i = 1; i < argc; i++){
+		if(strcmp(argv[i], "--threads") == 0 && i+1 < argc){
+			if(! get_int_param(argv[++i], &options->threads) || options->threads < 1){
+				fprintf(stderr, "Error: number of threads should be a positive integer\n");
+				return false;
+			}
+		}
+		else if(strcmp(argv[i], "--generate") == 0 && i+1 < argc){
+			if(! get_int_param(argv[++i], &options->generate) || options->generate < 1){
+				fprintf(stderr, "Error: number of puzzles should be a positive integer\n");
+				return false;
+			}
+		}
+		else if(strcmp(argv[i], "--size") == 0 && i+2 < argc){
+			if(! get_int_param(argv[++i], &options->cell_w) || options->cell_w < 1 ||
+					! get_int_param(argv[++i], &options->cell_h) || options->cell_h < 1){
+				fprintf(stderr, "Error: block dimensions should be positive integers\n");
+				return false;
+			}
+		}
+		else if(strcmp(argv[i], "--fill") == 0 && i+2 < argc){
+			if(! get_int_param(argv[++i], &options->add) || ! get_int_param(argv[++i], &options->remain)){
+				fprintf(stderr, "Error: fill values should be non-negative integers\n");
+				return false;
+			}
+		}
+		else if(strcmp(argv[i], "--style") == 0 && i+1 < argc && options->gen_word_num < MAX_GEN_WORDS){
+			options->gen_words[options->gen_word_num++] = argv[++i];
+		}
+		else if(strcmp(argv[i], "--solve") == 0 && i+1 < argc){
+			options->solve = argv[++i];
+		}
+		else if(strcmp(argv[i], "--count") == 0 && i+1 < argc){
+			if(! get_int_param(argv[++i], &options->count_limit) || options->count_limit < 0){
+				fprintf(stderr, "Error: limit should be a non-negative integer\n");
+				return false;
+			}
+			options->count = true;
+		}
+		else if(strcmp(argv[i], "--script") == 0){
+			options->script = true;
+		}
+		else if(strcmp(argv[i], "--commands") == 0 && i+1 < argc){
+			options->commands = argv[++i];
+		}
+		else if(strcmp(argv[i], "--output") == 0 && i+1 < argc){
+			options->output = argv[++i];
+		}
+		else if(strcmp(argv[i], "--seed") == 0 && i+1 < argc){
+			if(! get_seed(argv[++i], &options->seed)){
+				fprintf(stderr, "Error: seed should be a non-negative integer of at most %lu\n", ULONG_MAX);
+				return false;
+			}
+			options->seeded = true;
+		}
+		else{
+			fprintf(stderr, "Error: invalid option %s\n", argv[i]);
+			fprintf(stderr, "Usage: %s [--threads <num>] [--seed <num>] [--script] [--commands <file>]\n", argv[0]);
+			fprintf(stderr, "       %s --generate <count> [--size <cell_w> <cell_h>] [--fill <add> <remain>]\n", argv[0]);
+			fprintf(stderr, "           [--style <word>]... [--output <file>] [--threads <num>] [--seed <num>]\n");
+			fprintf(stderr, "       %s --solve <file> [--count <limit>] [--threads <num>]\n", argv[0]);
+			return false;
+		}
+	}
+	return true;
+}
+
 /*
-gets line from stdin into "str", that does not exceed MAX_COMMAND_LENGTH
+gets line from "input" into "str", that does not exceed MAX_COMMAND_LENGTH
 
 returns 0 on failure (EOF already reached)
 returns -1 if line is too long
@@ -83,8 +182,8 @@ newline char is removed
 str must be at least 2 characters longer than MAX_COMMAND_LENGTH
 
 */
-int get_line(char* str){
-	if(fgets(str, MAX_COMMAND_LENGTH+2, stdin)){
+int get_line(FILE* input, char* str){
+	if(fgets(str, MAX_COMMAND_LENGTH+2, input)){
 		int len; /* length */
 		for(len = 0; str[len]; len++){
 			if(str[len] == '\n'){ /* if new line found then line is short enough */
@@ -128,7 +227,7 @@ char* copy_until_blank(char* src, char* dst){
 	return src;
 }
 
-#define COMMAND_NUM 15
+#define COMMAND_NUM 16
 
 /* all commands */
 CommandType commands[COMMAND_NUM] = {
@@ -146,6 +245,7 @@ CommandType commands[COMMAND_NUM] = {
 	CMD_COUNT_SOLUTIONS,
 	CMD_AUTOFILL,
 	CMD_RESET,
+	CMD_STATS,
 	CMD_EXIT};
 
 /* all commands as text */
@@ -164,12 +264,13 @@ const char* command_texts[COMMAND_NUM] = {
 	"num_solutions",
 	"autofill",
 	"reset",
+	"stats",
 	"exit"};
 /* possible number of paramters for each command  */
-int min_param_nums[COMMAND_NUM] = {1,0,1,0,3,0,2,0,0,1,2,0,0,0,0};
-int max_param_nums[COMMAND_NUM] = {1,1,1,0,3,0,2,0,0,1,2,0,0,0,0};
+int min_param_nums[COMMAND_NUM] = {1,0,1,0,3,0,2,0,0,1,2,0,0,0,0,0};
+int max_param_nums[COMMAND_NUM] = {1,1,1,0,3,0,4,0,0,1,2,1,1,0,1,0};
 	
-CommandType get_command(GameMode mode, char** params, int* param_num){
+CommandType get_command(FILE* input, bool prompt, GameMode mode, char** params, int* param_num){
 	
 	bool in_long = false; /* saves whether last input was too long */
 	char command[MAX_COMMAND_LENGTH + 2]; /* extra place for nullchar and newline*/
@@ -178,9 +279,9 @@ CommandType get_command(GameMode mode, char** params, int* param_num){
 		char* str = command; /* current position in command string */
 		int line_code; /* get_line's return code */
 		
-		if(!in_long) printf("Enter your command:\n");
+		if(prompt && !in_long) printf("Enter your command:\n");
 		
-		if((line_code = get_line(command))){
+		if((line_code = get_line(input, command))){
 			/* no error */
 			if(line_code == -1){
 				in_long = true;
@@ -225,7 +326,7 @@ CommandType get_command(GameMode mode, char** params, int* param_num){
 			printf("ERROR: invalid command\n"); /* line found, but command could not be recognized */
 		}
 		else{ /* eof reached or error encountered */
-			if(ferror(stdin)){
+			if(ferror(input)){
 				/* error in input reading */
 				fprintf(stderr,"Error: fgets has failed\n");
 				/* exit */
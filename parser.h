@@ -5,9 +5,10 @@ parser module, contains functions to get commands from terminal
 */
 
 #include <stdbool.h> /* boolean type */
+#include <stdio.h> /* FILE */
 
 #define MAX_COMMAND_LENGTH 256
-#define MAX_PARAM_NUM 3
+#define MAX_PARAM_NUM 4
 
 typedef enum game_mode_enum{
 	MODE_INIT,
@@ -33,16 +34,62 @@ typedef enum command_type_enum{
 	CMD_COUNT_SOLUTIONS,
 	CMD_AUTOFILL,
 	CMD_RESET,
+	CMD_STATS,
 	CMD_EXIT
 } CommandType;
 
 
+/*
+maximal number of generate option words in command line
+*/
+#define MAX_GEN_WORDS 4
+
+/*
+command line options
+*/
+typedef struct options_struct{
+	int threads; /* number of threads used for counting solutions (and batch modes) */
+	
+	/* batch generation */
+	int generate; /* number of puzzles to generate, 0 for interactive mode */
+	int cell_w, cell_h; /* block dimensions of generated puzzles */
+	int add, remain; /* parameters of generate command */
+	char* gen_words[MAX_GEN_WORDS]; /* words of generate options */
+	int gen_word_num;
+	char* output; /* output file, NULL for standard output */
+	
+	/* batch solving */
+	char* solve; /* input of batch solving ("-" for standard input), NULL for interactive mode */
+	bool count; /* whether solutions are counted instead of solving */
+	int count_limit; /* limit of counting, 0 for no limit */
+	
+	/* scripted game */
+	bool script; /* whether prompts and automatic board printing are suppressed */
+	char* commands; /* file of commands, NULL for standard input */
+	
+	bool seeded; /* whether a seed was given */
+	unsigned long seed; /* seed of random generators */
+} Options;
+
+/*
+reads command line options into "options" (unspecified options get default values)
+returns whether successful
+if not print error message
+*/
+bool get_options(int argc, char** argv, Options* options);
+
 /*
 extracts an integer from "str" into "param",
 returns whether succeeded
 */
 bool get_int_param(char* str, int* param);
 
+/*
+extracts a random seed (any unsigned long) from "str" into "seed",
+returns whether succeeded
+*/
+bool get_seed(char* str, unsigned long* seed);
+
 /*
 read int from str to out, in given limits (lower-upper)
 return whether successful
@@ -58,12 +105,13 @@ if not print error message
 bool get_bool(char* str, bool* out);
 
 /*
-gets command from command line,
+gets command from "input",
 given the game mode (init, solve or edit)
+prompts for command before reading if "prompt" is true
 returns type of command
 outputs parameters (if any) to params
 output number of parameters to param_num
 */
-CommandType get_command(GameMode mode, char** params, int* param_num);
+CommandType get_command(FILE* input, bool prompt, GameMode mode, char** params, int* param_num);
 
 #endif
\ No newline at end of file
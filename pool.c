@@ -0,0 +1,229 @@
+#include "pool.h"
+
+#include <stdlib.h> /* allocation functions */
+#include <stdio.h>
+
+#define INITIAL_DEQUE_CAPACITY 16
+
+/*
+pushes task to bottom of deque
+returns whether successful
+*/
+bool push_task(TaskDeque* deque, PoolTask task){
+	pthread_mutex_lock(&deque->lock);
+	if(deque->count == deque->capacity){
+		/* grow buffer, and move tasks to start of it */
+		int i;
+		PoolTask* tasks = calloc(2*deque->capacity, sizeof(PoolTask));
+		if(tasks == NULL){
+			fprintf(stderr,"Error: calloc has failed\n");
+			pthread_mutex_unlock(&deque->lock);
+			return false;
+		}
+		for(i = 0; i < deque->count; i++) tasks[i] = deque->tasks[(deque->top + i) % deque->capacity];
+		free(deque->tasks);
+		deque->tasks = tasks;
+		deque->capacity *= 2;
+		deque->top = 0;
+	}
+	deque->tasks[(deque->top + deque->count) % deque->capacity] = task;
+	deque->count++;
+	pthread_mutex_unlock(&deque->lock);
+	return true;
+}
+
+/*
+takes task from bottom (newest, if "steal" is false) or top (oldest) of deque
+returns whether there was a task
+*/
+bool take_task(TaskDeque* deque, PoolTask* task, bool steal){
+	bool found = false;
+	pthread_mutex_lock(&deque->lock);
+	if(deque->count > 0){
+		if(steal){
+			*task = deque->tasks[deque->top];
+			deque->top = (deque->top + 1) % deque->capacity;
+		}
+		else{
+			*task = deque->tasks[(deque->top + deque->count - 1) % deque->capacity];
+		}
+		deque->count--;
+		found = true;
+	}
+	pthread_mutex_unlock(&deque->lock);
+	return found;
+}
+
+/*
+main function of worker thread, gets its deque
+*/
+void* worker_main(void* arg){
+	TaskDeque* own = arg;
+	ThreadPool* pool = own->pool;
+	int worker = own - pool->deques; /* index of worker */
+
+	while(true){
+		PoolTask task;
+		int i;
+
+		/* wait for a task, and claim it */
+		pthread_mutex_lock(&pool->lock);
+		while(pool->queued == 0 && !pool->stop) pthread_cond_wait(&pool->added, &pool->lock);
+		if(pool->queued == 0){ /* stopped and no more tasks */
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		pool->queued--;
+		pthread_mutex_unlock(&pool->lock);
+
+		/*
+		claimed task is in some deque: try own deque first, then steal from others
+		(other workers might take it first, but then a task they claimed is left for this worker)
+		*/
+		for(i = 0; ; i = (i+1) % pool->thread_num){
+			if(i == 0 && take_task(own, &task, false)) break;
+			if(i != 0 && take_task(&pool->deques[(worker + i) % pool->thread_num], &task, true)) break;
+		}
+
+		task.func(task.arg, worker);
+
+		pthread_mutex_lock(&pool->lock);
+		pool->pending--;
+		if(pool->pending == 0) pthread_cond_broadcast(&pool->done);
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	return NULL;
+}
+
+/*
+tells workers to exit, and waits for first "created" workers
+*/
+void stop_workers(ThreadPool* pool, int created){
+	int i;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = true;
+	pthread_cond_broadcast(&pool->added);
+	pthread_mutex_unlock(&pool->lock);
+
+	for(i = 0; i < created; i++) pthread_join(pool->threads[i], NULL);
+}
+
+/*
+frees memory and synchronization objects of pool with no running workers
+*/
+void destroy_pool(ThreadPool* pool){
+	int i;
+
+	for(i = 0; i < pool->thread_num; i++){
+		free(pool->deques[i].tasks);
+		pthread_mutex_destroy(&pool->deques[i].lock);
+	}
+
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->added);
+	pthread_cond_destroy(&pool->done);
+	free(pool->deques);
+	free(pool->threads);
+	free(pool);
+}
+
+ThreadPool* create_pool(int thread_num){
+	ThreadPool* pool;
+	int i;
+
+	pool = malloc(sizeof(ThreadPool));
+	if(pool == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
+		return NULL;
+	}
+
+	pool->thread_num = thread_num;
+	pool->queued = pool->pending = pool->next = 0;
+	pool->stop = false;
+
+	pool->threads = calloc(thread_num, sizeof(pthread_t));
+	if(pool->threads == NULL){
+		fprintf(stderr,"Error: calloc has failed\n");
+		free(pool);
+		return NULL;
+	}
+
+	pool->deques = calloc(thread_num, sizeof(TaskDeque));
+	if(pool->deques == NULL){
+		fprintf(stderr,"Error: calloc has failed\n");
+		free(pool->threads);
+		free(pool);
+		return NULL;
+	}
+
+	for(i = 0; i < thread_num; i++){
+		pool->deques[i].pool = pool;
+		pool->deques[i].capacity = INITIAL_DEQUE_CAPACITY;
+		pool->deques[i].top = pool->deques[i].count = 0;
+		pool->deques[i].tasks = calloc(INITIAL_DEQUE_CAPACITY, sizeof(PoolTask));
+		if(pool->deques[i].tasks == NULL){
+			fprintf(stderr,"Error: calloc has failed\n");
+			while(--i >= 0){
+				free(pool->deques[i].tasks);
+				pthread_mutex_destroy(&pool->deques[i].lock);
+			}
+			free(pool->deques);
+			free(pool->threads);
+			free(pool);
+			return NULL;
+		}
+		pthread_mutex_init(&pool->deques[i].lock, NULL);
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->added, NULL);
+	pthread_cond_init(&pool->done, NULL);
+
+	for(i = 0; i < thread_num; i++){
+		if(pthread_create(&pool->threads[i], NULL, worker_main, &pool->deques[i])){
+			fprintf(stderr,"Error: pthread_create has failed\n");
+			stop_workers(pool, i); /* only join created threads */
+			destroy_pool(pool);
+			return NULL;
+		}
+	}
+
+	return pool;
+}
+
+void free_pool(ThreadPool* pool){
+	pool_wait(pool);
+	stop_workers(pool, pool->thread_num);
+	destroy_pool(pool);
+}
+
+bool pool_submit(ThreadPool* pool, int worker, TaskFunction func, void* arg){
+	PoolTask task;
+	task.func = func;
+	task.arg = arg;
+
+	if(worker < 0){
+		/* spread outside tasks over deques */
+		pthread_mutex_lock(&pool->lock);
+		worker = pool->next;
+		pool->next = (pool->next + 1) % pool->thread_num;
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	if(! push_task(&pool->deques[worker], task)) return false;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->queued++;
+	pool->pending++;
+	pthread_cond_signal(&pool->added);
+	pthread_mutex_unlock(&pool->lock);
+	return true;
+}
+
+void pool_wait(ThreadPool* pool){
+	pthread_mutex_lock(&pool->lock);
+	while(pool->pending > 0) pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
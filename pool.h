@@ -0,0 +1,82 @@
+#ifndef _POOL_H
+#define _POOL_H
+/*
+thread pool module
+runs tasks on a fixed number of worker threads,
+each worker has its own task deque and steals from other workers when it runs out
+*/
+
+#include <stdbool.h>
+#include <pthread.h>
+
+/*
+task function, gets task argument and index of worker running it
+*/
+typedef void (*TaskFunction)(void* arg, int worker);
+
+/*
+a single task
+*/
+typedef struct pool_task{
+	TaskFunction func;
+	void* arg;
+} PoolTask;
+
+/*
+double ended task queue of a worker
+owner pushes and pops at the bottom, other workers steal from the top
+*/
+typedef struct task_deque{
+	struct thread_pool* pool; /* pool of owner worker */
+	pthread_mutex_t lock;
+	PoolTask* tasks; /* circular buffer */
+	int capacity; /* length of tasks */
+	int top; /* position of oldest task */
+	int count; /* number of tasks */
+} TaskDeque;
+
+/*
+structure of a thread pool
+*/
+typedef struct thread_pool{
+	int thread_num; /* number of workers */
+	pthread_t* threads;
+	TaskDeque* deques; /* one per worker */
+
+	pthread_mutex_t lock; /* protects all fields below */
+	pthread_cond_t added; /* signaled when tasks are added or pool is stopped */
+	pthread_cond_t done; /* signaled when all tasks are finished */
+	int queued; /* number of tasks in deques not yet claimed by a worker */
+	int pending; /* number of tasks not yet finished */
+	int next; /* deque for next task submitted from outside the pool */
+	bool stop; /* whether workers should exit */
+} ThreadPool;
+
+/*
+creates pool with given number of worker threads
+on error returns NULL
+*/
+ThreadPool* create_pool(int thread_num);
+
+/*
+waits for all tasks, stops workers and frees pool
+*/
+void free_pool(ThreadPool* pool);
+
+/*
+adds task to pool
+
+"worker" is the index of the submitting worker (task is added to its own deque),
+or -1 when submitting from outside the pool
+
+returns whether successful
+*/
+bool pool_submit(ThreadPool* pool, int worker, TaskFunction func, void* arg);
+
+/*
+waits until all submitted tasks (including tasks they submit) are finished
+must not be called from a task
+*/
+void pool_wait(ThreadPool* pool);
+
+#endif
@@ -0,0 +1,61 @@
+#include "prng.h"
+
+#define MASK_32 0xFFFFFFFFUL
+
+/*
+rotates 32 bit word "x" left by "k" bits
+*/
+#define ROTATE_32(x, k) ((((x) << (k)) | ((x) >> (32 - (k)))) & MASK_32)
+
+/*
+mixes 32 bit value into a well distributed one (finalizer of murmur3)
+*/
+unsigned long mix_32(unsigned long x){
+	x &= MASK_32;
+	x ^= x >> 16;
+	x = (x * 0x85EBCA6BUL) & MASK_32;
+	x ^= x >> 13;
+	x = (x * 0xC2B2AE35UL) & MASK_32;
+	x ^= x >> 16;
+	return x;
+}
+
+void seed_random(Random* rng, unsigned long seed, unsigned long stream){
+	int i;
+	/* all bits of seed are used, shift is split so it is defined for 32 bit longs */
+	unsigned long x = mix_32(seed) ^ mix_32(mix_32((seed >> 16) >> 16) ^ stream ^ 0x9E3779B9UL);
+	
+	/* state must not be all zeros, golden ratio increments ensure that */
+	for(i = 0; i < 4; i++){
+		x = (x + 0x9E3779B9UL) & MASK_32;
+		rng->state[i] = mix_32(x ^ mix_32(stream + i));
+	}
+	if(!(rng->state[0] | rng->state[1] | rng->state[2] | rng->state[3])) rng->state[0] = 1;
+}
+
+unsigned long next_random(Random* rng){
+	unsigned long* s = rng->state;
+	unsigned long result = (ROTATE_32((s[1] * 5) & MASK_32, 7) * 9) & MASK_32;
+	unsigned long t = (s[1] << 9) & MASK_32;
+	
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = ROTATE_32(s[3], 11);
+	
+	return result;
+}
+
+int random_below(Random* rng, int n){
+	/* reject values of last incomplete range, so all results are equally likely */
+	unsigned long limit = MASK_32 - (MASK_32 % (unsigned long)n + 1) % (unsigned long)n;
+	unsigned long r;
+	
+	do{
+		r = next_random(rng);
+	} while(r > limit);
+	
+	return r % (unsigned long)n;
+}
@@ -0,0 +1,31 @@
+#ifndef _PRNG_H
+#define _PRNG_H
+/*
+pseudo random number generator module
+xoshiro128** generator, each generator keeps its own state so generators are reproducible and thread safe
+*/
+
+/*
+state of a generator, 4 words of 32 bits (kept in unsigned long, which has at least 32 bits)
+*/
+typedef struct random_struct{
+	unsigned long state[4];
+} Random;
+
+/*
+seeds generator, generators with same seed and different streams give unrelated sequences
+same seed and stream always give same sequence (on any platform)
+*/
+void seed_random(Random* rng, unsigned long seed, unsigned long stream);
+
+/*
+returns next 32 random bits
+*/
+unsigned long next_random(Random* rng);
+
+/*
+returns uniformly distributed random number in range 0,...,n-1 (n must be positive)
+*/
+int random_below(Random* rng, int n);
+
+#endif
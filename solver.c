@@ -1,263 +1,598 @@
 #include "solver.h"
 
-#include "gurobi_c.h"
+#include "candidates.h"
+#include "pool.h"
+#include "stats.h"
 
 #include <stdlib.h> /* malloc */
+#include <signal.h> /* interrupting count */
+#include <time.h> /* progress reports */
 
 #include <stdio.h> /* for formating gurobi condition names */
-bool count_solutions(Board* board, int* number){
 
+void clear_count(WideCount* count){
+	int i;
+	for(i = 0; i < COUNT_LIMBS; i++) count->limbs[i] = 0;
+}
+
+void increase_count(WideCount* count, unsigned long value){
+	int i;
+	count->limbs[0] += value;
+	/* carry */
+	for(i = 0; i < COUNT_LIMBS-1 && count->limbs[i] >= COUNT_BASE; i++){
+		count->limbs[i+1] += count->limbs[i] / COUNT_BASE;
+		count->limbs[i] %= COUNT_BASE;
+	}
+}
+
+void add_count(WideCount* count, WideCount* other){
+	int i;
+	for(i = 0; i < COUNT_LIMBS; i++) count->limbs[i] += other->limbs[i];
+	/* carry */
+	for(i = 0; i < COUNT_LIMBS-1; i++){
+		count->limbs[i+1] += count->limbs[i] / COUNT_BASE;
+		count->limbs[i] %= COUNT_BASE;
+	}
+}
+
+int compare_count(WideCount* count, unsigned long value){
+	int i;
+	for(i = COUNT_LIMBS-1; i >= 2; i--) if(count->limbs[i]) return 1; /* value is less than COUNT_BASE^2 */
+	/* compare two lowest limbs */
+	if(count->limbs[1] != value / COUNT_BASE) return count->limbs[1] > value / COUNT_BASE ? 1 : -1;
+	if(count->limbs[0] != value % COUNT_BASE) return count->limbs[0] > value % COUNT_BASE ? 1 : -1;
+	return 0;
+}
+
+void count_to_string(WideCount* count, char* str){
+	int i = COUNT_LIMBS-1;
+	while(i > 0 && count->limbs[i] == 0) i--; /* skip leading zero limbs */
+	str += sprintf(str, "%lu", count->limbs[i]);
+	/* other limbs are padded to full width */
+	for(i--; i >= 0; i--) str += sprintf(str, "%09lu", count->limbs[i]);
+}
+
+/*
+parallel counting splits the search tree into tasks until there are about
+TASKS_PER_THREAD tasks per thread, then counts each task serially
+*/
+#define TASKS_PER_THREAD 16
+
+/*
+serial search updates shared count state every FLUSH_NODES nodes
+*/
+#define FLUSH_NODES 65536
+
+/*
+seconds between progress reports of long counts
+*/
+#define PROGRESS_INTERVAL 10
+
+/*
+set by interrupt signal while counting
+*/
+volatile sig_atomic_t count_interrupted = 0;
+
+/*
+handler of interrupt signal while counting
+*/
+void interrupt_count(int sig){
+	count_interrupted = 1;
+	signal(sig, interrupt_count); /* handler might be reset on delivery */
+}
+
+/*
+shared state of a count
+*/
+typedef struct count_job_struct{
+	ThreadPool* pool; /* NULL if counting serially */
+	int split_width; /* tasks are split until this many tasks exist on their level */
+	int limit; /* stop after this many solutions if positive */
+	FILE* progress; /* output of progress reports, NULL for none */
+	time_t start; /* start time of count */
+	
+	pthread_mutex_t lock; /* protects fields below */
+	WideCount count; /* solutions found so far */
+	WideCount nodes; /* search nodes visited so far */
+	double done; /* fraction of search tree completely searched */
+	double* partial; /* fraction searched in current task of each worker */
+	time_t last_report; /* time of last progress report */
+	bool stop; /* whether limit is reached or count was interrupted */
+	bool error; /* whether some task has failed */
+} CountJob;
+
+/*
+prints progress of count if enough time has passed since last report
+job must be locked
+*/
+void report_progress(CountJob* job, int workers){
+	time_t now = time(NULL);
+	char nodes[COUNT_STRING_LENGTH], count[COUNT_STRING_LENGTH];
+	double done = job->done, elapsed = difftime(now, job->start);
+	int i;
+	
+	if(job->progress == NULL || difftime(now, job->last_report) < PROGRESS_INTERVAL) return;
+	job->last_report = now;
+	
+	for(i = 0; i < workers; i++) done += job->partial[i];
+	
+	count_to_string(&job->nodes, nodes);
+	count_to_string(&job->count, count);
+	fprintf(job->progress, "Progress: %s nodes visited, %s solutions found, %.3g%% searched", nodes, count, 100 * done);
+	if(done > 0) fprintf(job->progress, ", about %.0f seconds left", elapsed * (1 - done) / done); /* estimate by rate so far */
+	fprintf(job->progress, "\n");
+	fflush(job->progress);
+}
+
+/*
+returns number of solutions missing for job to reach its limit, 0 if it has no limit or reached it
+job must be locked
+*/
+int missing_solutions(CountJob* job){
+	if(job->limit <= 0 || compare_count(&job->count, job->limit) >= 0) return 0;
+	return job->limit - (job->count.limbs[1] * COUNT_BASE + job->count.limbs[0]); /* count is less than limit */
+}
+
+/*
+adds nodes and solutions found by worker to job, and updates fraction searched
+"finished" is the fraction of search tree completed by worker since last update
+outputs number of solutions still missing to reach limit to "missing" (see missing_solutions), unless it is NULL
+
+returns whether worker should continue searching
+*/
+bool update_job(CountJob* job, int worker, int nodes, int solutions, double partial, double finished, int* missing){
+	bool go;
+	
+	pthread_mutex_lock(&job->lock);
+	increase_count(&job->nodes, nodes);
+	STAT_COUNT(STAT_COUNT_NODES, nodes);
+	increase_count(&job->count, solutions);
+	job->partial[worker] = partial;
+	job->done += finished;
+	
+	if(count_interrupted || (job->limit > 0 && compare_count(&job->count, job->limit) >= 0)) job->stop = true;
+	report_progress(job, job->pool ? job->pool->thread_num : 1);
+	if(missing != NULL) *missing = missing_solutions(job);
+	
+	go = !(job->stop || job->error);
+	pthread_mutex_unlock(&job->lock);
+	return go;
+}
+
+/*
+counts solutions of given non erroneous board into job
+"weight" is the fraction of job's search tree this board is
+
+returns whether succeeded
+*/
+bool count_serial(CountJob* job, int worker, Board* board, double weight){
+	Candidates* cands; /* used numbers of rows, columns and blocks */
+	int N = board->cell_w * board->cell_h; /* for convenience and readability */
+	int words; /* words per mask */
 	int empty_num; /* number of empty places */
 	
 	/*
-	each simulated recursive call gets the next empty position as parameters
+	each simulated recursive call fills the empty position with fewest legal values
 	
-	these will be saved to x_stack and y_stack (x and y coordinates)
+	positions not yet filled are kept at the end of xs,ys (from stack_head on),
+	the position filled at each level is moved to that level's index
+	legal values of each level are saved to masks, their number to options and current value to values
 	*/
-	int* x_stack;
-	int* y_stack;
+	int* xs;
+	int* ys;
+	int* values;
+	int* options;
+	MaskWord* masks;
+	MaskWord* best_mask; /* legal values of best position found so far */
 	int stack_head = 0; /* position of stack head */
-	int count = 0;  /* solution counter */
+	bool descend = true; /* whether to choose a new position (or advance the current one) */
+	bool stopped = false; /* whether search was stopped before searching everything */
+	int count = 0;  /* solutions found since last update */
+	int nodes = 0; /* nodes visited since last update */
+	int limit; /* solutions missing to reach limit, 0 for no limit */
 	
+	pthread_mutex_lock(&job->lock);
+	stopped = job->limit > 0 && compare_count(&job->count, job->limit) >= 0; /* nothing missing */
+	limit = missing_solutions(job);
+	pthread_mutex_unlock(&job->lock);
+	if(stopped) return true;
 	
-	if(check_board(board)) {
-		number = 0;
-		return true;
-	} /* board is erronous */
+	cands = create_candidates(board);
+	if(cands == NULL) return false;
+	words = cands->words;
 	
-	x_stack = calloc(board->cell_w * board->cell_h * board->cell_w * board->cell_h, sizeof(int));
-	if(x_stack == NULL){
+	/* single block: masks (extra mask for candidates of current position), followed by 4 stacks of N*N ints */
+	masks = calloc(1, (N*N + 1) * words * sizeof(MaskWord) + 4 * N*N * sizeof(int));
+	if(masks == NULL){
 		fprintf(stderr,"Error: calloc has failed\n");
+		free_candidates(cands);
 		return false;
 	}
+	best_mask = masks + N*N*words;
+	xs = (int*)(best_mask + words);
+	ys = xs + N*N;
+	values = ys + N*N;
+	options = values + N*N;
 	
-	y_stack = calloc(board->cell_w * board->cell_h * board->cell_w * board->cell_h, sizeof(int));
-	if(y_stack == NULL){
-		fprintf(stderr,"Error: calloc has failed\n");
-		free(x_stack);
-		return false;
-	}
+	empty_num = count_empty_places(board, xs, ys);
 	
-	/* positions on the stack always remain the same, so we will calculate them before the recursion */
-	empty_num = count_empty_places(board, x_stack, y_stack);
-		
 	while(stack_head >= 0){ /* as long as stack is not empty */
-		if(stack_head == empty_num){
-			count++; /* board full */
-			stack_head--; /* go back */
-		}
-		else{
-			/* increase current position */
-			board->table[y_stack[stack_head]][x_stack[stack_head]] ++;
+		if(nodes >= FLUSH_NODES){
+			/* fraction searched: options before current value on each level, weighted by level size */
+			double partial = 0, scale = weight;
+			int i;
+			for(i = 0; i < stack_head; i++){
+				partial += scale * count_before(masks + i*words, words, values[i]) / options[i];
+				scale /= options[i];
+			}
 			
+			/* other workers might have found solutions, so limit is updated too */
+			if(! update_job(job, worker, nodes, count, partial, 0, &limit)){
+				stopped = true;
+				break;
+			}
+			nodes = count = 0;
+		}
+		
+		if(descend){
+			int i, best = -1, best_num = N+1; /* best position, and its number of legal values */
 			
-			if(board->table[y_stack[stack_head]][x_stack[stack_head]] > board->cell_w * board->cell_h){
-				/* all options for position were checked */
-				board->table[y_stack[stack_head]][x_stack[stack_head]] = 0; /* reset as empty */
+			if(stack_head == empty_num){
+				count++; /* board full */
+				if(count == limit){ /* no need to look further */
+					stopped = true;
+					break;
+				}
 				stack_head--; /* go back */
+				descend = false;
+				continue;
 			}
-			else{
-				if(!check_position(board, x_stack[stack_head], y_stack[stack_head])){
-					/* if no errors were created, go to next position */
-					stack_head++;
+			
+			/* find remaining position with fewest legal values */
+			for(i = stack_head; i < empty_num && best_num > 1; i++){
+				int num = get_candidates(cands, xs[i], ys[i], best_mask);
+				if(num < best_num){
+					best_num = num;
+					best = i;
 				}
-				/* otherwise next iteration will check next option for this position */
 			}
+			
+			if(best_num == 0){
+				stack_head--; /* dead end, go back */
+				descend = false;
+				continue;
+			}
+			
+			/* move best position to stack head */
+			i = xs[best]; xs[best] = xs[stack_head]; xs[stack_head] = i;
+			i = ys[best]; ys[best] = ys[stack_head]; ys[stack_head] = i;
+			
+			get_candidates(cands, xs[stack_head], ys[stack_head], masks + stack_head*words);
+			options[stack_head] = best_num;
+			values[stack_head] = 0;
+			descend = false;
+		}
+		
+		/* advance current position to next legal value */
+		if(values[stack_head] != 0) unmark_used(cands, xs[stack_head], ys[stack_head], values[stack_head]);
+		
+		values[stack_head] = next_candidate(masks + stack_head*words, words, values[stack_head]);
+		
+		if(values[stack_head] == 0){
+			stack_head--; /* all options for position were checked, go back */
+		}
+		else{
+			mark_used(cands, xs[stack_head], ys[stack_head], values[stack_head]);
+			nodes++;
+			stack_head++; /* go to next position */
+			descend = true;
 		}
 	}
 	
-	free(x_stack);
-	free(y_stack);
+	free(masks);
+	free_candidates(cands);
 	
-	*number = count;
+	update_job(job, worker, nodes, count, 0, stopped ? 0 : weight, NULL);
 	return true; /* success */
 }
 
-Board* solve(Board* board){
-	/* gurobi environment and model */
-	GRBenv   *env   = NULL;
-	GRBmodel *model = NULL;
-	int cell_w = board->cell_w, cell_h = board->cell_h, N = cell_w*cell_h; /* for convenience and readability */
-	double *sol; /* for retreving  solution */
-	int *ind; /* for setting confinements */
-	double *val;
-	double *obj; /* objective function */
-	char *vtype; /* for setting to binary type */
-	int optimstatus; /* gurobi status */
-	int i,x,y,cell_x,cell_y,num; /* for loops */
-	Board* new_board; /* for returning solution */
+/*
+a subtree of the search, given by a partially filled board
+*/
+typedef struct count_task_struct{
+	CountJob* job;
+	Board* board; /* owned by task */
+	int width; /* number of tasks on this level of the search tree (estimated) */
+} CountTask;
 
-	/* allocations, N^3 variables, N variables per condition */
-	sol = calloc(N*N*N, sizeof(double));
-	if(sol == NULL){
-		fprintf(stderr,"Error: calloc has failed\n");
-		return NULL;
+void count_task(void* arg, int worker);
+
+/*
+creates task for given board and adds it to pool
+board is freed on failure
+
+returns whether successful
+*/
+bool submit_count_task(CountJob* job, int worker, Board* board, int width){
+	CountTask* task = malloc(sizeof(CountTask));
+	if(task == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
+		free_board(board);
+		return false;
 	}
-	vtype = calloc(N*N*N, sizeof(char));
-	if(vtype == NULL){
-		fprintf(stderr,"Error: calloc has failed\n");
-		free(sol);
-		return NULL;
+	task->job = job;
+	task->board = board;
+	task->width = width;
+	
+	if(! pool_submit(job->pool, worker, count_task, task)){
+		free_board(board);
+		free(task);
+		return false;
 	}
-	ind = calloc(N, sizeof(int));
-	if(ind == NULL){
+	return true;
+}
+
+/*
+fills positions with a single legal value on task's board,
+then either splits task on the position with fewest legal values or counts it serially
+
+returns whether succeeded
+*/
+bool run_count_task(CountTask* task, int worker){
+	CountJob* job = task->job;
+	Board* board = task->board;
+	int N = board->cell_w * board->cell_h;
+	Candidates* cands;
+	MaskWord* mask; /* legal values of best position */
+	int x,y,best_x = 0,best_y = 0,best_num,num;
+	
+	if(task->width >= job->split_width){
+		return count_serial(job, worker, board, 1.0 / task->width); /* small enough */
+	}
+	
+	cands = create_candidates(board);
+	if(cands == NULL) return false;
+	mask = calloc(cands->words, sizeof(MaskWord));
+	if(mask == NULL){
 		fprintf(stderr,"Error: calloc has failed\n");
-		free(sol);
-		free(vtype);
-		return NULL;
+		free_candidates(cands);
+		return false;
 	}
-	val = calloc(N, sizeof(double));
-	if(val == NULL){
+	
+	do{
+		/* find empty position with fewest legal values */
+		best_num = N+1;
+		for(y = 0; y < N && best_num > 1; y++){
+			for(x = 0; x < N && best_num > 1; x++){
+				if(board->table[y][x] == 0){
+					num = get_candidates(cands, x, y, mask);
+					if(num < best_num){
+						best_num = num;
+						best_x = x;
+						best_y = y;
+					}
+				}
+			}
+		}
+		
+		if(best_num == 1){
+			/* only one option, fill it in place */
+			num = next_candidate(mask, cands->words, 0);
+			set_cell(board, best_x, best_y, num);
+			mark_used(cands, best_x, best_y, num);
+		}
+	} while(best_num == 1);
+	
+	if(best_num > 1 && best_num <= N){
+		/* create a task for each legal value, they cover the whole subtree */
+		get_candidates(cands, best_x, best_y, mask);
+		for(num = next_candidate(mask, cands->words, 0); num; num = next_candidate(mask, cands->words, num)){
+			Board* child = copy_board(board);
+			if(child == NULL) break;
+			set_cell(child, best_x, best_y, num);
+			if(! submit_count_task(job, worker, child, task->width * best_num)) break;
+		}
+		if(num != 0){ /* stopped before going over all values */
+			free(mask);
+			free_candidates(cands);
+			return false;
+		}
+	}
+	else{
+		/* either board is full, or there is no legal value for some position */
+		update_job(job, worker, 0, best_num == N+1 ? 1 : 0, 0, 1.0 / task->width, NULL);
+	}
+	
+	free(mask);
+	free_candidates(cands);
+	return true;
+}
+
+/*
+task function of parallel count
+*/
+void count_task(void* arg, int worker){
+	CountTask* task = arg;
+	bool skip;
+	
+	/* no need to continue after failure, or after limit is reached */
+	pthread_mutex_lock(&task->job->lock);
+	skip = task->job->error || task->job->stop;
+	pthread_mutex_unlock(&task->job->lock);
+	
+	if(!skip && ! run_count_task(task, worker)){
+		pthread_mutex_lock(&task->job->lock);
+		task->job->error = true;
+		pthread_mutex_unlock(&task->job->lock);
+	}
+	
+	free_board(task->board);
+	free(task);
+}
+
+bool count_solutions(Board* board, int threads, int limit, FILE* progress, WideCount* number, bool* interrupted){
+	CountJob job;
+	void (*old_handler)(int); /* previous interrupt handler */
+	
+	clear_count(number);
+	*interrupted = false;
+	if(check_board(board)) return true; /* board is erronous */
+	
+	job.pool = NULL;
+	job.split_width = threads * TASKS_PER_THREAD;
+	job.limit = limit;
+	job.progress = progress;
+	job.start = job.last_report = time(NULL);
+	clear_count(&job.count);
+	clear_count(&job.nodes);
+	job.done = 0;
+	job.stop = job.error = false;
+	
+	job.partial = calloc(threads, sizeof(double));
+	if(job.partial == NULL){
 		fprintf(stderr,"Error: calloc has failed\n");
-		free(sol);
-		free(vtype);
-		free(ind);
+		return false;
+	}
+	
+	if(threads > 1){
+		job.pool = create_pool(threads);
+		if(job.pool == NULL){
+			free(job.partial);
+			return false;
+		}
+	}
+	pthread_mutex_init(&job.lock, NULL);
+	
+	/* interrupt stops count with partial result */
+	count_interrupted = 0;
+	old_handler = signal(SIGINT, interrupt_count);
+	
+	if(job.pool){
+		Board* root = copy_board_to(board, NULL); /* board of first task, not pooled since tasks run in workers */
+		if(root == NULL || ! submit_count_task(&job, -1, root, 1)) job.error = true;
+		free_pool(job.pool); /* waits for all tasks */
+	}
+	else if(! count_serial(&job, 0, board, 1.0)){
+		job.error = true;
+	}
+	
+	signal(SIGINT, old_handler == SIG_ERR ? SIG_DFL : old_handler);
+	*interrupted = count_interrupted != 0;
+	
+	pthread_mutex_destroy(&job.lock);
+	free(job.partial);
+	
+	/* tasks running in parallel might pass the limit together */
+	if(limit > 0 && compare_count(&job.count, limit) > 0){
+		clear_count(number);
+		increase_count(number, limit);
+	}
+	else{
+		*number = job.count;
+	}
+	return !job.error;
+}
+
+#ifdef USE_GUROBI
+
+void free_solver(SolverContext* solver){
+	/* context might be partially created */
+	if(solver->model) GRBfreemodel(solver->model);
+	if(solver->env) GRBfreeenv(solver->env);
+	free(solver->bounds);
+	free(solver->sol);
+	free(solver);
+}
+
+/*
+prints last gurobi error of context, frees it, and returns NULL
+*/
+SolverContext* solver_error(SolverContext* solver){
+	fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(solver->env));
+	free_solver(solver);
+	return NULL;
+}
+
+SolverContext* create_solver(int cell_w, int cell_h){
+	SolverContext* solver;
+	int N = cell_w*cell_h; /* for convenience and readability */
+	int ind[MAX_BOARD_SIZE]; /* for setting confinements, N variables per condition */
+	double val[MAX_BOARD_SIZE];
+	char* vtype; /* for setting to binary type */
+	char name[40]; /* name of condition, long enough for any int values */
+	int i,x,y,cell_x,cell_y,num; /* for loops */
+	STAT_TIMER(start)
+	
+	solver = malloc(sizeof(SolverContext));
+	if(solver == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
 		return NULL;
 	}
-	obj = calloc(N*N*N, sizeof(double));
-	if(val == NULL){
+	solver->cell_w = cell_w;
+	solver->cell_h = cell_h;
+	solver->node_limit = 0;
+	solver->stopped = false;
+	solver->env = NULL;
+	solver->model = NULL;
+	
+	/* allocations, N^3 variables */
+	solver->bounds = calloc(N*N*N, sizeof(double));
+	solver->sol = calloc(N*N*N, sizeof(double));
+	vtype = calloc(N*N*N, sizeof(char));
+	if(solver->bounds == NULL || solver->sol == NULL || vtype == NULL){
 		fprintf(stderr,"Error: calloc has failed\n");
-		free(sol);
 		free(vtype);
-		free(ind);
-		free(val);
+		free_solver(solver);
 		return NULL;
 	}
 	
 	/* initialize gurobi, might be errors */
-	if(GRBloadenv(&env, "sudoku_gurobi.log")){
-		free(sol);
+	if(GRBloadenv(&solver->env, "sudoku_gurobi.log")){
 		free(vtype);
-		free(ind);
-		free(val);
-		free(obj);
-		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
-		return NULL;
+		return solver_error(solver);
 	}
-	if(GRBsetintparam(env, "LogToConsole", 0)){ /* silence gurobi */
-		free(sol);
+	if(GRBsetintparam(solver->env, "LogToConsole", 0) /* silence gurobi */
+		|| GRBnewmodel(solver->env, &solver->model, "mip1", 0, NULL, NULL, NULL, NULL, NULL)){
 		free(vtype);
-		free(ind);
-		free(val);
-		free(obj);
-		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
-		return NULL;
-	}
-	if(GRBnewmodel(env, &model, "mip1", 0, NULL, NULL, NULL, NULL, NULL)){
-		free(sol);
-		free(vtype);
-		free(ind);
-		free(val);
-		free(obj);
-		GRBfreeenv(env);
-		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
-		return NULL;
+		return solver_error(solver);
 	}
 	
-	for(i=0; i<N*N*N; i++) {vtype[i] = GRB_BINARY;obj[i] = 0.0;}
+	for(i=0; i<N*N*N; i++) vtype[i] = GRB_BINARY;
 	
-	if(GRBaddvars(model, N*N*N, 0, NULL, NULL, NULL, NULL, NULL, NULL, vtype, NULL)){
-		/* error */
-		free(sol);
+	if(GRBaddvars(solver->model, N*N*N, 0, NULL, NULL, NULL, NULL, NULL, NULL, vtype, NULL)){
 		free(vtype);
-		free(ind);
-		free(val);
-		free(obj);
-		GRBfreemodel(model);
-		GRBfreeenv(env);
-		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
-		return NULL;
+		return solver_error(solver);
 	}
-	
-	free(obj);
 	free(vtype);
-
-	if(GRBupdatemodel(model)){
-		/* error */
-		free(sol);
-		free(ind);
-		free(val);
-		GRBfreemodel(model);
-		GRBfreeenv(env);
-		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
-		return NULL;
-	}
-	/* one number per cell */
+	
+	if(GRBupdatemodel(solver->model)) return solver_error(solver);
+	
+	for(i = 0; i < N; i++) val[i] = 1;
+	
+	/* one number per cell (values of board are set by lower bounds) */
 	for(x=0;x<N;x++){
 		for(y=0;y<N;y++){
-			char name[9]; /* name of condition */
 			sprintf(name, "cell%2d%2d",x,y);
-			if(board->table[y][x] == 0){ /* position is not set */
-				for(num = 0; num < N; num++){
-					ind[num] = N*N*x + N*y + num;
-					val[num] = 1;
-				}
-				if(GRBaddconstr(model, N, ind, val, GRB_EQUAL, 1, name)){
-					free(sol);
-					free(ind);
-					free(val);
-					GRBfreemodel(model);
-					GRBfreeenv(env);
-					fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
-					return NULL;
-				}
-			}
-			else{
-				num = board->table[y][x]-1;
-				ind[0] = N*N*x + N*y + num;
-				val[0] = 1;
-				if(GRBaddconstr(model, 1, ind, val, GRB_EQUAL, 1, name)){
-					free(sol);
-					free(ind);
-					free(val);
-					GRBfreemodel(model);
-					GRBfreeenv(env);
-					fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
-					return NULL;
-				}
-			}
+			for(num = 0; num < N; num++) ind[num] = N*N*x + N*y + num;
+			if(GRBaddconstr(solver->model, N, ind, val, GRB_EQUAL, 1, name)) return solver_error(solver);
 		}
 	}
-		
+	
 	/* one appearence per row */
 	for(y=0;y<N;y++){
 		for(num=0;num<N;num++){
-			char name[8];
 			sprintf(name, "row%2d%2d",num,y);
-			for(x = 0; x < N; x++){
-				ind[x] = N*N*x + N*y + num;
-				val[x] = 1;				
-			}
-			if(GRBaddconstr(model, N, ind, val, GRB_EQUAL, 1, name)){
-				free(sol);
-				free(ind);
-				free(val);
-				GRBfreemodel(model);
-				GRBfreeenv(env);
-		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
-				return NULL;
-			}
+			for(x = 0; x < N; x++) ind[x] = N*N*x + N*y + num;
+			if(GRBaddconstr(solver->model, N, ind, val, GRB_EQUAL, 1, name)) return solver_error(solver);
 		}
 	}
 	
 	/* one appearence per column */
 	for(x=0;x<N;x++){
 		for(num=0;num<N;num++){
-			char name[8];
 			sprintf(name, "col%2d%2d",num,x);
-			for(y = 0; y < N; y++){
-				ind[y] = N*N*x + N*y + num;
-				val[y] = 1;				
-			}
-			if(GRBaddconstr(model, N, ind, val, GRB_EQUAL, 1, name)){
-				free(sol);
-				free(ind);
-				free(val);
-				GRBfreemodel(model);
-				GRBfreeenv(env);
-		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
-				return NULL;
-			}
+			for(y = 0; y < N; y++) ind[y] = N*N*x + N*y + num;
+			if(GRBaddconstr(solver->model, N, ind, val, GRB_EQUAL, 1, name)) return solver_error(solver);
 		}
 	}
 	
@@ -266,7 +601,6 @@ Board* solve(Board* board){
 		for(cell_y=0;cell_y<cell_w;cell_y++){
 			int bx,by; /* for loop over block */
 			for(num=0;num<N;num++){
-				char name[12];
 				sprintf(name, "block%2d%2d%2d",num,cell_x,cell_y);
 				for(bx = 0; bx<cell_w;bx++){
 					for(by = 0; by<cell_h;by++){
@@ -274,77 +608,186 @@ Board* solve(Board* board){
 						x = bx+cell_x*cell_w;
 						y = by+cell_y*cell_h;
 						ind[i] = N*N*x + N*y + num;
-						val[i] = 1;
 					}
 				}
-				if(GRBaddconstr(model, N, ind, val, GRB_EQUAL, 1, name)){
-					free(sol);
-					free(ind);
-					free(val);
-					GRBfreemodel(model);
-					GRBfreeenv(env);
-		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
-					return NULL;
-				}
+				if(GRBaddconstr(solver->model, N, ind, val, GRB_EQUAL, 1, name)) return solver_error(solver);
 			}
 		}
 	}
-		
-	free(ind);
-	free(val);
-	
-	if(GRBoptimize(model)){
-		free(sol);
-		GRBfreemodel(model);
-		GRBfreeenv(env);
-		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
+	
+	if(GRBupdatemodel(solver->model)) return solver_error(solver);
+	
+	STAT_TIME(STAT_SOLVER_BUILD, start);
+	return solver;
+}
+
+Board* solve_with(SolverContext* solver, Board* board){
+	int N = board->cell_w*board->cell_h; /* for convenience and readability */
+	int optimstatus; /* gurobi status */
+	int x,y,num; /* for loops */
+	Board* new_board; /* for returning solution */
+	STAT_TIMER(start)
+	STAT_TIMER(phase)
+	
+	/* set values of board: variable of a set value must be 1 */
+	for(x=0;x<N;x++){
+		for(y=0;y<N;y++){
+			for(num=0;num<N;num++) solver->bounds[N*N*x + N*y + num] = 0;
+			if(board->table[y][x] != 0) solver->bounds[N*N*x + N*y + board->table[y][x]-1] = 1;
+		}
+	}
+	
+	solver->stopped = false;
+	
+	if(GRBsetdblattrarray(solver->model, GRB_DBL_ATTR_LB, 0, N*N*N, solver->bounds)
+		|| GRBsetdblparam(GRBgetenv(solver->model), "NodeLimit", solver->node_limit > 0 ? (double)solver->node_limit : GRB_INFINITY)){
+		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(solver->env));
 		return NULL;
 	}
-	/* get status */
-	if(GRBgetintattr(model, GRB_INT_ATTR_STATUS, &optimstatus)){
-		free(sol);
-		GRBfreemodel(model);
-		GRBfreeenv(env);
-		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
+	STAT_TIME(STAT_SOLVER_LOAD, phase);
+	
+	STAT_RESTART(phase);
+	if(GRBoptimize(solver->model)
+		|| GRBgetintattr(solver->model, GRB_INT_ATTR_STATUS, &optimstatus)){ /* get status */
+		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(solver->env));
 		return NULL;
 	}
+	STAT_TIME(STAT_SOLVER_SEARCH, phase);
+#ifdef USE_STATS
+	{
+		double node_count;
+		if(! GRBgetdblattr(solver->model, GRB_DBL_ATTR_NODECOUNT, &node_count)) STAT_COUNT(STAT_SOLVER_NODES, (long)node_count);
+	}
+#endif
+	
 	if(optimstatus == GRB_INF_OR_UNBD || optimstatus == GRB_UNBOUNDED || optimstatus == GRB_INFEASIBLE){
-		free(sol);
-		GRBfreemodel(model);
-		GRBfreeenv(env);
+		STAT_TIME(STAT_SOLVE, start);
 		return board; /* no solution */
 	}
+	if(optimstatus == GRB_NODE_LIMIT){
+		solver->stopped = true;
+		STAT_TIME(STAT_SOLVE, start);
+		return board; /* gave up */
+	}
 	if(optimstatus != GRB_OPTIMAL){
-		free(sol);
-		GRBfreemodel(model);
-		GRBfreeenv(env);
 		return NULL; /* some problem */
 	}
 	
 	/* get solution */
-	if(GRBgetdblattrarray(model, GRB_DBL_ATTR_X, 0, N*N*N, sol)){
-		free(sol);
-		GRBfreemodel(model);
-		GRBfreeenv(env);
-		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(env));
+	STAT_RESTART(phase);
+	if(GRBgetdblattrarray(solver->model, GRB_DBL_ATTR_X, 0, N*N*N, solver->sol)){
+		fprintf(stderr,"Error in Gurobi: %s\n", GRBgeterrormsg(solver->env));
 		return NULL;
 	}
 	
-	GRBfreemodel(model);
-	GRBfreeenv(env);
-	
 	/* if this point is reached there is a solution in sol */
 	new_board = copy_board(board);
 	
-	if(new_board == NULL){
-		free(sol);
+	if(new_board == NULL) return NULL;
+	
+	for(x=0;x<N;x++)for(y=0;y<N;y++)for(num=0;num<N;num++) if(solver->sol[N*N*x+N*y+num] > 0.5 /* ==1 */)
+		set_cell(new_board, x, y, num+1); /* set the number */
+	
+	STAT_TIME(STAT_SOLVER_READ, phase);
+	STAT_TIME(STAT_SOLVE, start);
+	return new_board;
+}
+
+#else
+
+SolverContext* create_solver(int cell_w, int cell_h){
+	SolverContext* solver;
+	STAT_TIMER(start)
+	
+	solver = malloc(sizeof(SolverContext));
+	if(solver == NULL){
+		fprintf(stderr,"Error: malloc has failed\n");
+		return NULL;
+	}
+	solver->cell_w = cell_w;
+	solver->cell_h = cell_h;
+	solver->node_limit = 0;
+	solver->stopped = false;
+	
+	solver->matrix = create_dlx(cell_w, cell_h);
+	if(solver->matrix == NULL){
+		free(solver);
 		return NULL;
 	}
 	
-	for(x=0;x<N;x++)for(y=0;y<N;y++)for(num=0;num<N;num++) if(sol[N*N*x+N*y+num] > 0.5 /* ==1 */)
-		new_board->table[y][x] = num+1; /* set the number */
+	STAT_TIME(STAT_SOLVER_BUILD, start);
+	return solver;
+}
+
+void free_solver(SolverContext* solver){
+	free_dlx(solver->matrix);
+	free(solver);
+}
+
+Board* solve_with(SolverContext* solver, Board* board){
+	Board* new_board; /* for returning solution */
+	bool found;
+	STAT_TIMER(start)
+	STAT_TIMER(search)
+	
+	new_board = copy_board(board);
+	if(new_board == NULL) return NULL;
+	
+	/* matrix is restored after solving, so it is reused by next solve */
+	solver->matrix->node_limit = solver->node_limit;
+	STAT_RESTART(search);
+	found = dlx_solve(solver->matrix, board, new_board);
+	STAT_TIME(STAT_SOLVER_SEARCH, search);
+	STAT_TIME(STAT_SOLVE, start);
+	if(! found){
+		solver->stopped = solver->matrix->stopped;
+		free_board(new_board);
+		return board; /* no solution */
+	}
+	solver->stopped = false;
+	
+	return new_board;
+}
+
+#endif
+
+SolverContext* get_solver(Game* game){
+	if(game->solver == NULL) game->solver = create_solver(game->board->cell_w, game->board->cell_h);
+	return game->solver;
+}
+
+Board* game_solve(Game* game, Board* board){
+	SolverContext* solver = get_solver(game);
+	if(solver == NULL) return NULL;
+	return solve_with(solver, board);
+}
+
+Board* solve_current(Game* game){
+	MoveListNode* node = game->current_state;
+	Board* sol;
+	
+	/* already solved */
+	if(node->solution != NULL) return node->solution;
+	if(node->unsolvable) return game->board;
+	
+	sol = game_solve(game, game->board);
+	if(sol == NULL) return NULL;
+	
+	if(sol == game->board) node->unsolvable = true;
+	else game->solution = node->solution = sol;
+	
+	return sol;
+}
+
+Board* solve(Board* board){
+	SolverContext* solver;
+	Board* new_board;
+	
+	solver = create_solver(board->cell_w, board->cell_h);
+	if(solver == NULL) return NULL;
 	
-	free(sol);
+	new_board = solve_with(solver, board);
 	
+	free_solver(solver);
 	return new_board;
 }
@@ -7,18 +7,125 @@ contains functions for solving sudoku boards
 
 #include "game.h"
 
+#ifdef USE_GUROBI
+#include "gurobi_c.h"
+#else
+#include "dlx.h"
+#endif
+
+/*
+solver context for boards of given dimensions
+keeps structure of the problem (constraints not depending on board values) between solves,
+so each solve only updates the values of the board
+*/
+typedef struct solver_context{
+	int cell_w, cell_h; /* dimensions of solved boards */
+	long node_limit; /* solve gives up after this many search nodes, 0 for no limit */
+	bool stopped; /* whether last solve gave up because of node limit */
+#ifdef USE_GUROBI
+	GRBenv* env;
+	GRBmodel* model; /* variables and constraints, values are set by lower bounds */
+	double* bounds; /* lower bounds of variables, N^3 values */
+	double* sol; /* for retreving solution, N^3 values */
+#else
+	DlxMatrix* matrix; /* exact cover matrix */
+#endif
+} SolverContext;
+
+/*
+creates solver context for boards with given dimensions
+on error returns NULL
+*/
+SolverContext* create_solver(int cell_w, int cell_h);
+
+/*
+frees solver context
+*/
+void free_solver(SolverContext* solver);
+
 /*
-generates a solved copy of given board, returns null pointer if no solution exists
-on failure returns same pointer
+generates a solved copy of given board (with dimensions of context) using given context
+on failure (no solution exists, or search stopped by node limit) returns same pointer
+on error returns null
+*/
+Board* solve_with(SolverContext* solver, Board* board);
+
+/*
+returns solver context of game, creating it on first use
+on error returns NULL
+*/
+SolverContext* get_solver(Game* game);
+
+/*
+same as solve_with, using solver context of game
+*/
+Board* game_solve(Game* game, Board* board);
+
+/*
+solves current board of game, result is kept by current move node so each game state is solved once
+returns solution (kept by game, must not be freed), or game board if board has no solution
+on error returns null
+*/
+Board* solve_current(Game* game);
+
+/*
+generates a solved copy of given board, using a temporary solver context
+on failure (no solution exists) returns same pointer
 on error returns null
 */
 Board* solve(Board* board);
 
+/*
+unsigned counter wide enough for solution counts of large boards
+saved as base COUNT_BASE digits, least significant first
+*/
+#define COUNT_LIMBS 4
+#define COUNT_BASE 1000000000UL
+
+typedef struct wide_count_struct{
+	unsigned long limbs[COUNT_LIMBS];
+} WideCount;
+
+/*
+length of string needed to print a counter
+*/
+#define COUNT_STRING_LENGTH (9*COUNT_LIMBS + 1)
+
+/*
+sets counter to 0
+*/
+void clear_count(WideCount* count);
+/*
+adds "value" (less than COUNT_BASE) to counter
+*/
+void increase_count(WideCount* count, unsigned long value);
+/*
+adds "other" to counter
+*/
+void add_count(WideCount* count, WideCount* other);
+/*
+returns -1, 0 or 1 if counter is less than, equal to or greater than "value"
+value must be less than COUNT_BASE^2
+*/
+int compare_count(WideCount* count, unsigned long value);
+/*
+writes counter in decimal to "str", which has at least COUNT_STRING_LENGTH characters
+*/
+void count_to_string(WideCount* count, char* str);
+
 /*
 outputs number of possible solutions to given board to "number"
+search is split between "threads" threads if it is more than 1
+
+if "limit" is positive, search stops as soon as "limit" solutions are found
+(so "number" is at most "limit"), limit of 2 is enough to check if solution is unique
+
+long counts print their progress periodically to "progress" (not printed if it is NULL),
+and can be stopped with an interrupt signal (ctrl-c)
+in which case "interrupted" is set and "number" is the number of solutions found so far
+
 returns whether succeded
-also prints gurobi errors
 */
-bool count_solutions(Board* board, int* number);
+bool count_solutions(Board* board, int threads, int limit, FILE* progress, WideCount* number, bool* interrupted);
 
 #endif
\ No newline at end of file
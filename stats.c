@@ -0,0 +1,68 @@
+#include "stats.h"
+
+#include <stdio.h>
+
+#ifdef USE_STATS
+
+#include <pthread.h> /* counters are updated by worker threads */
+
+/*
+names of measured operations, by kind
+*/
+const char* stat_names[STAT_KINDS] = {
+	"check_position",
+	"copy_board",
+	"solve",
+	"solver build",
+	"solver load",
+	"solver search",
+	"solver read",
+	"solver nodes",
+	"count nodes"};
+
+long stat_calls[STAT_KINDS];
+clock_t stat_times[STAT_KINDS];
+pthread_mutex_t stat_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void stat_record(StatKind kind, long calls, clock_t time){
+	pthread_mutex_lock(&stat_lock);
+	stat_calls[kind] += calls;
+	stat_times[kind] += time;
+	pthread_mutex_unlock(&stat_lock);
+}
+
+void print_stats(void){
+	int i;
+
+	pthread_mutex_lock(&stat_lock);
+	for(i = 0; i < STAT_KINDS; i++){
+		if(i == STAT_SOLVER_NODES || i == STAT_COUNT_NODES) printf("%s: %ld\n", stat_names[i], stat_calls[i]);
+		else{
+			/* processor time of whole program, so it includes other threads running meanwhile */
+			printf("%s: %ld calls, %.6f seconds\n", stat_names[i], stat_calls[i], (double)stat_times[i] / CLOCKS_PER_SEC);
+		}
+	}
+	pthread_mutex_unlock(&stat_lock);
+}
+
+void reset_stats(void){
+	int i;
+
+	pthread_mutex_lock(&stat_lock);
+	for(i = 0; i < STAT_KINDS; i++){
+		stat_calls[i] = 0;
+		stat_times[i] = 0;
+	}
+	pthread_mutex_unlock(&stat_lock);
+}
+
+#else
+
+void print_stats(void){
+	printf("Statistics are not enabled, rebuild with make STATS=1\n");
+}
+
+void reset_stats(void){
+}
+
+#endif
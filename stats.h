@@ -0,0 +1,77 @@
+#ifndef _STATS_H
+#define _STATS_H
+/*
+statistics module
+counts calls and processor time of hot operations, and search nodes, for profiling real sessions
+
+enabled at compile time by defining USE_STATS (make STATS=1),
+otherwise all macros below are empty, so instrumented code has no cost
+*/
+
+#include <time.h> /* clock */
+
+/*
+measured operations
+*/
+typedef enum stat_kind_enum{
+	STAT_CHECK_POSITION, /* checking position for errors */
+	STAT_COPY_BOARD, /* copying boards */
+	STAT_SOLVE, /* solving a board with a solver context, including phases below */
+	STAT_SOLVER_BUILD, /* building a solver context (gurobi model or dlx matrix) */
+	STAT_SOLVER_LOAD, /* setting board values in gurobi model */
+	STAT_SOLVER_SEARCH, /* gurobi optimization or dlx search */
+	STAT_SOLVER_READ, /* reading gurobi solution */
+	STAT_SOLVER_NODES, /* search nodes of solver (counted, not timed) */
+	STAT_COUNT_NODES, /* search nodes of solution counting (counted, not timed) */
+	STAT_KINDS
+} StatKind;
+
+#ifdef USE_STATS
+
+/*
+declares timer "name" and starts it, must be last declaration of block (and not followed by a semicolon)
+*/
+#define STAT_TIMER(name) clock_t name = clock();
+/*
+starts timer "name" again
+*/
+#define STAT_RESTART(name) ((name) = clock())
+/*
+adds a call of "kind", with time since timer "name" started
+*/
+#define STAT_TIME(kind, name) stat_record(kind, 1, clock() - (name))
+/*
+adds "num" (not evaluated when disabled) to calls of "kind", without time
+*/
+#define STAT_COUNT(kind, num) stat_record(kind, num, 0)
+
+/*
+adds "calls" calls and "time" processor time to given kind, thread safe
+*/
+void stat_record(StatKind kind, long calls, clock_t time);
+
+#else
+
+#define STAT_TIMER(name)
+#define STAT_RESTART(name) ((void)0)
+#define STAT_TIME(kind, name) ((void)0)
+#define STAT_COUNT(kind, num) ((void)0)
+
+#endif
+
+/*
+parameter of stats command clearing statistics
+*/
+#define STATS_RESET "reset"
+
+/*
+prints all statistics since start or last reset, or a message if statistics are not enabled
+*/
+void print_stats(void);
+
+/*
+resets all statistics to 0
+*/
+void reset_stats(void);
+
+#endif
@@ -0,0 +1,81 @@
+/* mmap is POSIX, not part of ANSI C */
+#define _POSIX_C_SOURCE 200112L
+
+#include "store.h"
+
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h> /* fstat */
+#include <sys/mman.h> /* mmap */
+#include <fcntl.h> /* open */
+#include <unistd.h> /* close */
+
+int open_store(char* filename, PuzzleStore* store){
+	struct stat info;
+	void* map;
+	int fd = open(filename, O_RDONLY);
+	
+	if(fd < 0){
+		fprintf(stderr, "Error: File %s doesn't exist or cannot be opened\n", filename);
+		return -1;
+	}
+	if(fstat(fd, &info) != 0){
+		fprintf(stderr, "Error: fstat has failed\n");
+		close(fd);
+		return -1;
+	}
+	if(! S_ISREG(info.st_mode) || info.st_size < PACKED_HEADER_SIZE){
+		close(fd);
+		return 0; /* pipes and short files are not stores */
+	}
+	
+	map = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd); /* mapping stays valid after closing */
+	if(map == MAP_FAILED){
+		fprintf(stderr, "Error: mmap has failed\n");
+		return -1;
+	}
+	
+	store->data = map;
+	store->length = info.st_size;
+	store->mapped = true;
+	
+	if(! is_packed(store->data, store->length)){
+		munmap(map, info.st_size);
+		return 0;
+	}
+	if(! open_packed_view(store->data, store->length, &store->view)){
+		munmap(map, info.st_size);
+		return -1;
+	}
+	
+	/* puzzles are read in order by batch jobs */
+	posix_madvise(map, info.st_size, POSIX_MADV_SEQUENTIAL);
+	return 1;
+}
+
+bool open_memory_store(unsigned char* data, long length, PuzzleStore* store){
+	store->data = data;
+	store->length = length;
+	store->mapped = false;
+	return open_packed_view(data, length, &store->view);
+}
+
+void close_store(PuzzleStore* store){
+	if(store->mapped) munmap(store->data, store->length);
+}
+
+long store_count(PuzzleStore* store){
+	return store->view.count;
+}
+
+bool store_view(PuzzleStore* store, long index, PuzzleView* view){
+	long length;
+	
+	view->record = packed_record(&store->view, index, &length);
+	return record_dimensions(view->record, length, &view->cell_w, &view->cell_h);
+}
+
+bool view_to_board(PuzzleView* view, Board* board, bool* fixed){
+	return unpack_board(view->record, board, fixed);
+}
@@ -0,0 +1,64 @@
+#ifndef _STORE_H
+#define _STORE_H
+/*
+puzzle store module
+read only puzzle database: a packed container (see packed module) mapped to memory,
+puzzles are accessed by index through the container's offset index, without copying or parsing the file
+*/
+
+#include "packed.h"
+
+/*
+mapped container
+*/
+typedef struct puzzle_store{
+	unsigned char* data; /* mapped file */
+	long length;
+	bool mapped; /* whether data is mapped by store (and not owned by caller) */
+	PackedView view; /* records and index inside mapped file */
+} PuzzleStore;
+
+/*
+puzzle inside a store, valid while store is open
+*/
+typedef struct puzzle_view{
+	const unsigned char* record; /* packed record in mapped file */
+	int cell_w, cell_h;
+} PuzzleView;
+
+/*
+maps file as a store
+returns 1 on success, 0 if file is not a packed container (nothing is printed), and -1 on error (printing error)
+*/
+int open_store(char* filename, PuzzleStore* store);
+
+/*
+opens store of packed container already in memory (owned by caller, and kept while store is used)
+returns whether successful, if not prints error
+*/
+bool open_memory_store(unsigned char* data, long length, PuzzleStore* store);
+
+/*
+unmaps store, views of its puzzles can no longer be used
+*/
+void close_store(PuzzleStore* store);
+
+/*
+returns number of puzzles in store
+*/
+long store_count(PuzzleStore* store);
+
+/*
+outputs view of puzzle with given index (0 to store_count-1), checking its dimensions
+returns whether successful, if not prints error
+*/
+bool store_view(PuzzleStore* store, long index, PuzzleView* view);
+
+/*
+sets values of viewed puzzle in board of its dimensions (see unpack_board)
+positions marked fixed are set in "fixed" (N*N values, row by row), unless it is NULL
+returns whether successful, if not prints error
+*/
+bool view_to_board(PuzzleView* view, Board* board, bool* fixed);
+
+#endif